@@ -1,9 +1,80 @@
 #include "ansi-escapes.h"
 
+#include <string.h>
+
 #define ESC "\x1b"
+#define DEFAULT_BACKGROUND 0
+
+typedef struct attributes {
+    uint8_t background;
+    bool reverse;
+    bool bold;
+} attributes_t;
 
 struct termios original;
 
+static writer_t screen;
+static bool screen_ready = false;
+static attributes_t current = {DEFAULT_BACKGROUND, false, false};
+static attributes_t wanted = {DEFAULT_BACKGROUND, false, false};
+
+static writer_t *get_screen(void) {
+    if (!screen_ready) {
+        writer_init(&screen, STDOUT_FILENO);
+        screen_ready = true;
+    }
+    return &screen;
+}
+
+static void emit(const char *text) {
+    writer_write(get_screen(), text, strlen(text));
+}
+
+static void append_code(char *sequence, size_t *length, uint8_t code) {
+    if (*length > 2) {
+        sequence[(*length)++] = ';';
+    }
+    if (code >= 10) {
+        sequence[(*length)++] = (char) ('0' + code / 10);
+    }
+    sequence[(*length)++] = (char) ('0' + code % 10);
+}
+
+static void apply_attributes(void) {
+    if (current.background == wanted.background &&
+        current.reverse == wanted.reverse && current.bold == wanted.bold) {
+        return;
+    }
+
+    char sequence[16] = ESC"[";
+    size_t length = 2;
+    if ((current.background != DEFAULT_BACKGROUND &&
+         wanted.background == DEFAULT_BACKGROUND) ||
+        (current.reverse && !wanted.reverse) || (current.bold && !wanted.bold)) {
+        append_code(sequence, &length, 0);
+        current = (attributes_t) {DEFAULT_BACKGROUND, false, false};
+    }
+    if (wanted.bold && !current.bold) {
+        append_code(sequence, &length, 1);
+    }
+    if (wanted.reverse && !current.reverse) {
+        append_code(sequence, &length, 7);
+    }
+    if (wanted.background != current.background) {
+        append_code(sequence, &length, wanted.background);
+    }
+    sequence[length++] = 'm';
+    writer_write(get_screen(), sequence, length);
+    current = wanted;
+}
+
+static void restore_screen(void) {
+    wanted = (attributes_t) {DEFAULT_BACKGROUND, false, false};
+    apply_attributes();
+    emit(ESC"[?25h");
+    screen_flush();
+}
+
 void enable_raw_mode() {
     tcgetattr(STDIN_FILENO, &original);
     atexit(disable_raw_mode);
@@ -17,42 +88,73 @@ void disable_raw_mode() {
 }
 
 void enable_cursor() {
-    printf(ESC"[?25h");
+    emit(ESC"[?25h");
 }
 
 void hide_cursor() {
-    atexit(enable_cursor);
-    printf(ESC"[?25l");
+    atexit(restore_screen);
+    emit(ESC"[?25l");
 }
 
 void clear_console() {
-    printf(ESC"[H"ESC"[J");
+    apply_attributes();
+    emit(ESC"[H"ESC"[J");
+}
+
+void move_cursor(uint32_t row, uint32_t column) {
+    char sequence[32];
+    int length = snprintf(sequence, sizeof(sequence), ESC"[%"PRIu32";%"PRIu32"H",
+                          row, column);
+    writer_write(get_screen(), sequence, (size_t) length);
+}
+
+void clear_line() {
+    apply_attributes();
+    emit(ESC"[K");
 }
 
 void player_field() {
-    printf(ESC"[42m");
+    wanted.background = 42;
 }
 
 void cursor_field() {
-    printf(ESC"[7m");
+    wanted.reverse = true;
 }
 
 void frame_colour() {
-    printf(ESC"[43m");
+    wanted.background = 43;
 }
 
 void field_colour_one() {
-    printf(ESC"[44m");
+    wanted.background = 44;
 }
 
 void field_colour_two() {
-    printf(ESC"[41m");
+    wanted.background = 41;
 }
 
 void bold() {
-    printf(ESC"[1m");
+    wanted.bold = true;
 }
 
 void reset_colour() {
-    printf(ESC"[m");
+    wanted = (attributes_t) {DEFAULT_BACKGROUND, false, false};
+}
+
+void screen_write(const char *text, size_t length) {
+    apply_attributes();
+    writer_write(get_screen(), text, length);
+}
+
+void screen_text(const char *text) {
+    screen_write(text, strlen(text));
+}
+
+void screen_uint64(uint64_t number) {
+    apply_attributes();
+    writer_uint64(get_screen(), number);
+}
+
+void screen_flush() {
+    writer_flush(get_screen());
 }
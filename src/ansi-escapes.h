@@ -1,6 +1,13 @@
 /** @file
  * Funkcje obsługujące konsolę za pomocą ANSI escape codes
  *
+ * Tekst i sekwencje sterujące gromadzone są w jednym buforze, który trafia
+ * do konsoli dopiero po wywołaniu @ref screen_flush, więc cała klatka
+ * wypisywana jest zwykle jednym wywołaniem systemowym. Funkcje ustawiające
+ * kolory jedynie zapamiętują żądane atrybuty, a sekwencja je zmieniająca
+ * wypisywana jest przed kolejnym tekstem i tylko wtedy, gdy atrybuty różnią
+ * się od aktywnych w konsoli.
+ *
  * @author Szymon Frąckowiak
  * @date 17.05.2020
  */
@@ -8,6 +15,7 @@
 #ifndef GAMMA_ANSI_ESCAPES_H
 #define GAMMA_ANSI_ESCAPES_H
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -15,6 +23,7 @@
 #include <termios.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include "buffered-io.h"
 
 /** @brief Włącza specjalny tryb pracy terminala.
  * Pozwala na wczytywanie klawiszy bez ich wyświetlania oraz
@@ -28,12 +37,24 @@ void disable_raw_mode();
 /** @brief Pokazuje kursor (jeśli był ukryty). */
 void enable_cursor();
 
-/** @brief Ukrywa kursor. */
+/** @brief Ukrywa kursor.
+ * Przy zakończeniu programu przywracane są domyślne atrybuty i kursor,
+ * a bufor konsoli jest wypisywany.
+ */
 void hide_cursor();
 
 /** @brief Czyści konsolę. */
 void clear_console();
 
+/** @brief Przesuwa kursor konsoli.
+ * @param[in] row     - numer wiersza liczony od 1,
+ * @param[in] column  - numer kolumny liczony od 1.
+ */
+void move_cursor(uint32_t row, uint32_t column);
+
+/** @brief Czyści wiersz od kursora do końca. */
+void clear_line();
+
 /** @brief Ustawia kolor dla pola gracza na planszy. */
 void player_field();
 
@@ -55,4 +76,23 @@ void bold();
 /** @brief Usuwa wszystkie ustawienia graficzne. */
 void reset_colour();
 
+/** @brief Dopisuje tekst do bufora konsoli.
+ * @param[in] text    - wskaźnik na tekst,
+ * @param[in] length  - długość tekstu w bajtach.
+ */
+void screen_write(const char *text, size_t length);
+
+/** @brief Dopisuje napis zakończony znakiem '\0' do bufora konsoli.
+ * @param[in] text    - wskaźnik na napis.
+ */
+void screen_text(const char *text);
+
+/** @brief Dopisuje do bufora konsoli liczbę w zapisie dziesiętnym.
+ * @param[in] number  - wypisywana liczba.
+ */
+void screen_uint64(uint64_t number);
+
+/** @brief Wypisuje do konsoli zawartość bufora. */
+void screen_flush();
+
 #endif //GAMMA_ANSI_ESCAPES_H
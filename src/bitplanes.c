@@ -0,0 +1,190 @@
+#include "bitplanes.h"
+
+#include <string.h>
+
+#define WORD_BITS 64
+#define BLOCK_TARGET_WORDS 512
+
+static uint64_t *get_row(bitplanes_t *bp, uint32_t player, uint32_t y) {
+    bitblock_t *block = bp->blocks[y >> bp->block_shift];
+    uint64_t row = y & (((uint32_t) 1 << bp->block_shift) - 1);
+    return block->words + bp->block_words * player + bp->row_words * row;
+}
+
+static uint64_t last_word_mask(bitplanes_t *bp) {
+    uint32_t rest = bp->width % WORD_BITS;
+    return rest == 0 ? UINT64_MAX : ((uint64_t) 1 << rest) - 1;
+}
+
+static uint64_t block_size(bitplanes_t *bp) {
+    return sizeof(bitblock_t) + bp->block_words * bp->planes * sizeof(uint64_t);
+}
+
+static void release_block(bitblock_t *block) {
+    if (block && atomic_fetch_sub(&block->references, 1) == 1) {
+        free(block);
+    }
+}
+
+static bitblock_t *new_empty_block(bitplanes_t *bp, uint32_t rows,
+                                   uint32_t references) {
+    bitblock_t *block = calloc(1, block_size(bp));
+    if (!block) {
+        return NULL;
+    }
+    atomic_init(&block->references, references);
+
+    uint64_t mask = last_word_mask(bp);
+    for (uint32_t y = 0; y < rows; y++) {
+        uint64_t *row = block->words + bp->row_words * y;
+        for (uint64_t i = 0; i + 1 < bp->row_words; i++) {
+            row[i] = UINT64_MAX;
+        }
+        row[bp->row_words - 1] = mask;
+    }
+    return block;
+}
+
+static bool new_table(bitplanes_t *bp) {
+    bp->blocks = calloc(bp->block_count, sizeof(bitblock_t *));
+    return bp->blocks != NULL;
+}
+
+bool bitplanes_init(bitplanes_t *bp, uint32_t width, uint32_t height,
+                    uint32_t players) {
+    bp->width = width;
+    bp->height = height;
+    bp->row_words = ((uint64_t) width + WORD_BITS - 1) / WORD_BITS;
+    bp->planes = players + 1;
+    bp->block_shift = 0;
+    bp->blocks = NULL;
+
+    if (players > BITPLANES_MAX_PLAYERS) {
+        return true;
+    }
+
+    while (bp->block_shift < 31 &&
+           ((uint64_t) 2 << bp->block_shift) <= height &&
+           bp->row_words * bp->planes * ((uint64_t) 2 << bp->block_shift) <=
+           BLOCK_TARGET_WORDS) {
+        bp->block_shift++;
+    }
+    bp->block_words = bp->row_words << bp->block_shift;
+    bp->block_count = (uint32_t) (((uint64_t) height +
+                                   ((uint64_t) 1 << bp->block_shift) - 1) >>
+                                  bp->block_shift);
+    if (!new_table(bp)) {
+        return false;
+    }
+
+    // Pełne bloki pustej planszy są takie same, więc wszystkie wskazują na
+    // jeden blok i są kopiowane przy pierwszej zmianie.
+    uint32_t full = height >> bp->block_shift;
+    uint32_t rest = height & (((uint32_t) 1 << bp->block_shift) - 1);
+    bitblock_t *empty = full > 0 ?
+                        new_empty_block(bp, (uint32_t) 1 << bp->block_shift,
+                                        full) : NULL;
+    bitblock_t *last = rest > 0 ? new_empty_block(bp, rest, 1) : NULL;
+    if ((full > 0 && !empty) || (rest > 0 && !last)) {
+        free(empty);
+        free(last);
+        free(bp->blocks);
+        bp->blocks = NULL;
+        return false;
+    }
+    for (uint32_t i = 0; i < full; i++) {
+        bp->blocks[i] = empty;
+    }
+    if (last) {
+        bp->blocks[full] = last;
+    }
+    return true;
+}
+
+bool bitplanes_share(bitplanes_t *bp, bitplanes_t *source) {
+    *bp = *source;
+    if (!bitplanes_enabled(source)) {
+        return true;
+    }
+    if (!new_table(bp)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < bp->block_count; i++) {
+        atomic_fetch_add(&source->blocks[i]->references, 1);
+        bp->blocks[i] = source->blocks[i];
+    }
+    return true;
+}
+
+void bitplanes_free(bitplanes_t *bp) {
+    for (uint32_t i = 0; bp->blocks && i < bp->block_count; i++) {
+        release_block(bp->blocks[i]);
+    }
+    free(bp->blocks);
+    bp->blocks = NULL;
+}
+
+bool bitplanes_enabled(bitplanes_t *bp) {
+    return bp->blocks != NULL;
+}
+
+bool bitplanes_own(bitplanes_t *bp, uint32_t y) {
+    if (!bitplanes_enabled(bp)) {
+        return true;
+    }
+    bitblock_t **block = bp->blocks + (y >> bp->block_shift);
+    if (atomic_load(&(*block)->references) == 1) {
+        return true;
+    }
+    bitblock_t *copy = malloc(block_size(bp));
+    if (!copy) {
+        return false;
+    }
+    memcpy(copy->words, (*block)->words, block_size(bp) - sizeof(bitblock_t));
+    atomic_init(&copy->references, 1);
+    release_block(*block);
+    *block = copy;
+    return true;
+}
+
+void bitplanes_move(bitplanes_t *bp, uint32_t x, uint32_t y, uint32_t from,
+                    uint32_t to) {
+    if (!bitplanes_enabled(bp)) {
+        return;
+    }
+    uint64_t word = x / WORD_BITS;
+    uint64_t bit = (uint64_t) 1 << (x % WORD_BITS);
+    get_row(bp, from, y)[word] &= ~bit;
+    get_row(bp, to, y)[word] |= bit;
+}
+
+static uint64_t neighbours_word(bitplanes_t *bp, uint32_t player, uint32_t y,
+                                uint64_t word) {
+    uint64_t *row = get_row(bp, player, y);
+    uint64_t result = row[word] << 1 | row[word] >> 1;
+    if (word > 0) {
+        result |= row[word - 1] >> (WORD_BITS - 1);
+    }
+    if (word + 1 < bp->row_words) {
+        result |= row[word + 1] << (WORD_BITS - 1);
+    }
+    if (y > 0) {
+        result |= get_row(bp, player, y - 1)[word];
+    }
+    if (y + 1 < bp->height) {
+        result |= get_row(bp, player, y + 1)[word];
+    }
+    return result;
+}
+
+uint64_t bitplanes_border_word(bitplanes_t *bp, uint32_t player, uint32_t y,
+                               uint64_t word) {
+    uint64_t valid = word + 1 == bp->row_words ?
+                     last_word_mask(bp) : UINT64_MAX;
+    uint64_t others = valid & ~(get_row(bp, player, y)[word] |
+                                get_row(bp, 0, y)[word]);
+    if (others == 0) {
+        return 0;
+    }
+    return others & neighbours_word(bp, player, y, word);
+}
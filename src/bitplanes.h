@@ -0,0 +1,120 @@
+/** @file
+ * Bitowe mapy zajętości planszy gry gamma
+ *
+ * @author Szymon Frąckowiak
+ * @date 17.10.2026
+ */
+
+#ifndef GAMMA_BITPLANES_H
+#define GAMMA_BITPLANES_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/** @brief Maksymalna liczba graczy, dla której tworzone są mapy bitowe.
+ * Każda mapa zajmuje jeden bit na pole planszy, więc dla większej liczby
+ * graczy mapy zajmowałyby więcej pamięci niż sama plansza.
+ */
+#define BITPLANES_MAX_PLAYERS 16
+
+/** @brief Struktura przechowująca blok wierszy map bitowych. */
+typedef struct bitblock {
+    atomic_uint references; ///< liczba kopii gry używających bloku
+    uint64_t words[];       ///< kolejne mapy, każda po @p block_words słów
+} bitblock_t;
+
+/** @brief Struktura przechowująca bitowe mapy zajętości planszy.
+ * Dla każdego gracza przechowywana jest mapa, w której bit pola jest
+ * ustawiony, jeśli gracz zajmuje to pole. Osobna mapa opisuje pola wolne.
+ * Każdy wiersz planszy zaczyna się od nowego słowa 64-bitowego, a bity poza
+ * planszą są zawsze wyzerowane. Dzięki temu wyszukiwanie pól o zadanym
+ * sąsiedztwie sprowadza się do przesunięć i operacji logicznych na całych
+ * słowach. Mapy są opcjonalne: jeśli graczy jest więcej niż
+ * @ref BITPLANES_MAX_PLAYERS, to wskaźnik @p blocks jest NULL.
+ * Mapy podzielone są na bloki kolejnych wierszy, z których każdy zawiera
+ * wszystkie mapy dla swoich wierszy. Bloki, podobnie jak fragmenty tablic
+ * pól, mogą być współdzielone przez kopie gry i są kopiowane przy pierwszej
+ * zmianie. Pełne bloki pustej planszy od początku wskazują na jeden wspólny
+ * blok, więc pamięć jest zajmowana tylko przez bloki ze zmienionymi
+ * wierszami.
+ */
+typedef struct bitplanes {
+    uint32_t width;         ///< szerokość planszy
+    uint32_t height;        ///< wysokość planszy
+    uint64_t row_words;     ///< liczba słów przypadająca na wiersz
+    uint32_t planes;        ///< liczba map, mapa 0 opisuje pola wolne
+    uint32_t block_shift;   ///< logarytm dwójkowy liczby wierszy w bloku
+    uint64_t block_words;   ///< liczba słów jednej mapy w bloku
+    uint32_t block_count;   ///< liczba bloków
+    bitblock_t **blocks;    ///< wskaźniki na kolejne bloki
+} bitplanes_t;
+
+/** @brief Tworzy mapy bitowe dla pustej planszy.
+ * Jeśli graczy jest więcej niż @ref BITPLANES_MAX_PLAYERS, to mapy nie są
+ * tworzone, a struktura jest oznaczana jako nieaktywna.
+ * @param[out] bp     - wskaźnik na inicjowaną strukturę,
+ * @param[in] width   - szerokość planszy,
+ * @param[in] height  - wysokość planszy,
+ * @param[in] players - liczba graczy.
+ * @return Wartość @p false, jeśli nie udało się zaalokować pamięci,
+ * a @p true w przeciwnym przypadku.
+ */
+bool bitplanes_init(bitplanes_t *bp, uint32_t width, uint32_t height,
+                    uint32_t players);
+
+/** @brief Zwalnia pamięć zajmowaną przez mapy bitowe.
+ * @param[in,out] bp  - wskaźnik na strukturę z mapami.
+ */
+void bitplanes_free(bitplanes_t *bp);
+
+/** @brief Tworzy mapy bitowe współdzielące wszystkie bloki z innymi mapami.
+ * @param[out] bp     - wskaźnik na inicjowaną strukturę,
+ * @param[in] source  - wskaźnik na kopiowane mapy.
+ * @return Wartość @p false, jeśli nie udało się zaalokować pamięci,
+ * a @p true w przeciwnym przypadku.
+ */
+bool bitplanes_share(bitplanes_t *bp, bitplanes_t *source);
+
+/** @brief Zapewnia, że blok z danym wierszem można zmieniać.
+ * Jeśli blok jest współdzielony, to zastępuje go prywatną kopią.
+ * @param[in,out] bp  - wskaźnik na strukturę z mapami,
+ * @param[in] y       - numer wiersza.
+ * @return Wartość @p false, jeśli nie udało się zaalokować pamięci na kopię,
+ * a @p true w przeciwnym przypadku.
+ */
+bool bitplanes_own(bitplanes_t *bp, uint32_t y);
+
+/** @brief Sprawdza, czy mapy bitowe są utrzymywane.
+ * @param[in] bp      - wskaźnik na strukturę z mapami.
+ * @return Wartość @p true, jeśli mapy istnieją, a @p false w przeciwnym
+ * przypadku.
+ */
+bool bitplanes_enabled(bitplanes_t *bp);
+
+/** @brief Przenosi pole z mapy jednego gracza do mapy innego.
+ * Blok z wierszem pola nie może być współdzielony (@ref bitplanes_own).
+ * @param[in,out] bp  - wskaźnik na strukturę z mapami,
+ * @param[in] x       - numer kolumny,
+ * @param[in] y       - numer wiersza,
+ * @param[in] from    - dotychczasowy gracz na polu lub 0 dla pola wolnego,
+ * @param[in] to      - nowy gracz na polu lub 0 dla pola wolnego.
+ */
+void bitplanes_move(bitplanes_t *bp, uint32_t x, uint32_t y, uint32_t from,
+                    uint32_t to);
+
+/** @brief Wyznacza słowo pól innych graczy sąsiadujących z graczem.
+ * Bit numer i wyniku odpowiada polu (64 * @p word + i, @p y) i jest
+ * ustawiony, jeśli pole zajmuje inny gracz, a co najmniej jeden z jego
+ * sąsiadów jest zajęty przez gracza @p player.
+ * @param[in] bp      - wskaźnik na strukturę z mapami,
+ * @param[in] player  - numer gracza,
+ * @param[in] y       - numer wiersza,
+ * @param[in] word    - numer słowa w wierszu.
+ * @return Słowo z zaznaczonymi polami.
+ */
+uint64_t bitplanes_border_word(bitplanes_t *bp, uint32_t player, uint32_t y,
+                               uint64_t word);
+
+#endif //GAMMA_BITPLANES_H
@@ -0,0 +1,193 @@
+#define _GNU_SOURCE
+
+#include "buffered-io.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define READER_BLOCK_SIZE 65536
+
+static bool map_file(reader_t *r) {
+    struct stat info;
+    if (fstat(r->fd, &info) != 0 || !S_ISREG(info.st_mode) ||
+        info.st_size <= 0 || (uint64_t) info.st_size > SIZE_MAX) {
+        return false;
+    }
+    off_t offset = lseek(r->fd, 0, SEEK_CUR);
+    if (offset < 0 || offset >= info.st_size) {
+        return false;
+    }
+
+    size_t size = (size_t) info.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, r->fd, 0);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    lseek(r->fd, info.st_size, SEEK_SET);
+
+    r->map = map;
+    r->map_size = size;
+    r->data = (const char *) map;
+    r->begin = (size_t) offset;
+    r->end = size;
+    r->eof = true;
+    return true;
+}
+
+void reader_init(reader_t *r, int fd) {
+    r->fd = fd;
+    r->data = NULL;
+    r->begin = 0;
+    r->end = 0;
+    r->buffer = NULL;
+    r->capacity = 0;
+    r->map = NULL;
+    r->map_size = 0;
+    r->eof = false;
+    r->before_read = NULL;
+    map_file(r);
+}
+
+static bool fill_buffer(reader_t *r) {
+    size_t available = r->end - r->begin;
+    if (r->begin > 0) {
+        memmove(r->buffer, r->buffer + r->begin, available);
+        r->begin = 0;
+        r->end = available;
+    }
+    if (r->end == r->capacity) {
+        size_t capacity = r->capacity == 0 ?
+                          READER_BLOCK_SIZE : 2 * r->capacity;
+        char *buffer = realloc(r->buffer, capacity);
+        if (!buffer) {
+            return false;
+        }
+        r->buffer = buffer;
+        r->capacity = capacity;
+    }
+    r->data = r->buffer;
+
+    if (r->before_read) {
+        r->before_read();
+    }
+    ssize_t n;
+    do {
+        n = read(r->fd, r->buffer + r->end, r->capacity - r->end);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        return false;
+    }
+    r->end += (size_t) n;
+    return true;
+}
+
+bool reader_line(reader_t *r, const char **line, size_t *length) {
+    while (true) {
+        const char *start = r->data + r->begin;
+        size_t available = r->end - r->begin;
+        const char *newline = available > 0 ?
+                              memchr(start, '\n', available) : NULL;
+        if (newline) {
+            *line = start;
+            *length = (size_t) (newline - start) + 1;
+            r->begin += *length;
+            return true;
+        }
+        if (r->eof || !fill_buffer(r)) {
+            r->eof = true;
+            if (r->begin == r->end) {
+                reader_close(r);
+                return false;
+            }
+            *line = r->data + r->begin;
+            *length = r->end - r->begin;
+            r->begin = r->end;
+            return true;
+        }
+    }
+}
+
+int reader_getc(reader_t *r) {
+    while (r->begin == r->end) {
+        if (r->eof || !fill_buffer(r)) {
+            reader_close(r);
+            return EOF;
+        }
+    }
+    return (unsigned char) r->data[r->begin++];
+}
+
+void reader_close(reader_t *r) {
+    if (r->map) {
+        munmap(r->map, r->map_size);
+    }
+    free(r->buffer);
+    r->data = NULL;
+    r->begin = 0;
+    r->end = 0;
+    r->buffer = NULL;
+    r->capacity = 0;
+    r->map = NULL;
+    r->map_size = 0;
+    r->eof = true;
+}
+
+void writer_init(writer_t *w, int fd) {
+    w->fd = fd;
+    w->length = 0;
+}
+
+void writer_flush(writer_t *w) {
+    size_t written = 0;
+    while (written < w->length) {
+        ssize_t n = write(w->fd, w->buffer + written, w->length - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        written += (size_t) n;
+    }
+    w->length = 0;
+}
+
+void writer_write(writer_t *w, const char *data, size_t length) {
+    while (length > 0) {
+        if (w->length == WRITER_BUFFER_SIZE) {
+            writer_flush(w);
+        }
+        size_t part = WRITER_BUFFER_SIZE - w->length;
+        if (part > length) {
+            part = length;
+        }
+        memcpy(w->buffer + w->length, data, part);
+        w->length += part;
+        data += part;
+        length -= part;
+    }
+}
+
+void writer_uint64(writer_t *w, uint64_t number) {
+    char digits[20];
+    char *c = digits + sizeof(digits);
+    do {
+        *--c = (char) ('0' + number % 10);
+        number /= 10;
+    } while (number > 0);
+    writer_write(w, c, (size_t) (digits + sizeof(digits) - c));
+}
+
+bool same_sink(int fd1, int fd2) {
+    struct stat info1, info2;
+    if (fstat(fd1, &info1) != 0 || fstat(fd2, &info2) != 0) {
+        return false;
+    }
+    return info1.st_dev == info2.st_dev && info1.st_ino == info2.st_ino;
+}
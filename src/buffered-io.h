@@ -0,0 +1,111 @@
+/** @file
+ * Buforowane wczytywanie danych wejściowych i wypisywanie wyników
+ *
+ * @author Szymon Frąckowiak
+ * @date 17.10.2026
+ */
+
+#ifndef GAMMA_BUFFERED_IO_H
+#define GAMMA_BUFFERED_IO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Rozmiar bufora, w którym gromadzone są dane do wypisania. */
+#define WRITER_BUFFER_SIZE 65536
+
+/** @brief Struktura przechowująca stan czytnika danych wejściowych.
+ * Jeśli deskryptor wskazuje na zwykły plik, to czytnik odwzorowuje go
+ * w pamięci i zwraca wiersze bezpośrednio z odwzorowania. W przeciwnym
+ * przypadku dane wczytywane są dużymi blokami do bufora, który rośnie tylko
+ * wtedy, gdy pojedynczy wiersz się w nim nie mieści.
+ */
+typedef struct reader {
+    int fd;                 ///< deskryptor, z którego czytane są dane
+    const char *data;       ///< początek dostępnych danych
+    size_t begin;           ///< indeks pierwszego nieprzetworzonego bajtu
+    size_t end;             ///< indeks za ostatnim dostępnym bajtem
+    char *buffer;           ///< bufor na dane wczytane z deskryptora
+    size_t capacity;        ///< rozmiar bufora
+    void *map;              ///< odwzorowanie pliku w pamięci lub NULL
+    size_t map_size;        ///< rozmiar odwzorowania
+    bool eof;               ///< czy nie ma już więcej danych do wczytania
+    void (*before_read)(void); ///< funkcja wywoływana przed blokującym
+                               ///< wczytaniem danych lub NULL
+} reader_t;
+
+/** @brief Struktura przechowująca bufor danych do wypisania.
+ * Dane trafiają do deskryptora dopiero po zapełnieniu bufora lub po
+ * wywołaniu @ref writer_flush, dzięki czemu wiele krótkich wyników
+ * wypisywanych jest jednym wywołaniem systemowym.
+ */
+typedef struct writer {
+    int fd;                             ///< deskryptor docelowy
+    size_t length;                      ///< liczba bajtów w buforze
+    char buffer[WRITER_BUFFER_SIZE];    ///< bufor danych
+} writer_t;
+
+/** @brief Przygotowuje czytnik danych z deskryptora.
+ * @param[out] r      - wskaźnik na inicjowany czytnik,
+ * @param[in] fd      - deskryptor, z którego czytane będą dane.
+ */
+void reader_init(reader_t *r, int fd);
+
+/** @brief Daje kolejny wiersz danych.
+ * Wiersz zawiera kończący go znak '\\n', o ile występuje on w danych.
+ * Wiersz nie jest zakończony znakiem '\\0' i pozostaje ważny do kolejnego
+ * wywołania funkcji czytnika.
+ * @param[in,out] r   - wskaźnik na czytnik,
+ * @param[out] line   - wskaźnik na początek wiersza,
+ * @param[out] length - długość wiersza w bajtach.
+ * @return Wartość @p true, jeśli wczytano wiersz, a @p false, jeśli
+ * skończyły się dane.
+ */
+bool reader_line(reader_t *r, const char **line, size_t *length);
+
+/** @brief Daje kolejny znak danych.
+ * @param[in,out] r   - wskaźnik na czytnik.
+ * @return Kod znaku lub EOF, jeśli skończyły się dane.
+ */
+int reader_getc(reader_t *r);
+
+/** @brief Zwalnia pamięć zajmowaną przez czytnik.
+ * Po wywołaniu czytnik zachowuje się tak, jakby skończyły się dane.
+ * @param[in,out] r   - wskaźnik na czytnik.
+ */
+void reader_close(reader_t *r);
+
+/** @brief Przygotowuje pusty bufor danych do wypisania.
+ * @param[out] w      - wskaźnik na inicjowany bufor,
+ * @param[in] fd      - deskryptor, do którego wypisywane będą dane.
+ */
+void writer_init(writer_t *w, int fd);
+
+/** @brief Dopisuje dane do bufora.
+ * @param[in,out] w   - wskaźnik na bufor,
+ * @param[in] data    - wskaźnik na dane,
+ * @param[in] length  - długość danych w bajtach.
+ */
+void writer_write(writer_t *w, const char *data, size_t length);
+
+/** @brief Dopisuje do bufora liczbę w zapisie dziesiętnym.
+ * @param[in,out] w   - wskaźnik na bufor,
+ * @param[in] number  - wypisywana liczba.
+ */
+void writer_uint64(writer_t *w, uint64_t number);
+
+/** @brief Wypisuje do deskryptora dane zgromadzone w buforze.
+ * @param[in,out] w   - wskaźnik na bufor.
+ */
+void writer_flush(writer_t *w);
+
+/** @brief Sprawdza, czy dwa deskryptory prowadzą do tego samego miejsca.
+ * @param[in] fd1     - pierwszy deskryptor,
+ * @param[in] fd2     - drugi deskryptor.
+ * @return Wartość @p true, jeśli oba deskryptory wskazują na ten sam plik,
+ * potok lub terminal, a @p false w przeciwnym przypadku.
+ */
+bool same_sink(int fd1, int fd2);
+
+#endif //GAMMA_BUFFERED_IO_H
@@ -0,0 +1,339 @@
+#define _GNU_SOURCE
+
+#include "chunks.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define CHUNK_DATA_SIZE (CHUNK_FIELDS * (sizeof(uint32_t) + sizeof(uint64_t) + \
+                                         sizeof(uint8_t)))
+
+// Rozmiar fragmentu razem ze strukturą, która leży tuż przed tablicami.
+#define CHUNK_SIZE (sizeof(chunk_t) + CHUNK_DATA_SIZE)
+
+// Najmniejszy obszar pamięci na fragmenty, dla którego opłaca się osobne
+// odwzorowanie: rozmiar dużej strony.
+#define ARENA_MIN_SIZE ((uint64_t) 2 << 20)
+
+static uint32_t empty_owners[CHUNK_FIELDS];
+static uint64_t empty_parents[CHUNK_FIELDS];
+static uint8_t empty_ranks[CHUNK_FIELDS];
+static chunk_t empty_chunk;
+
+// Strona opisów wspólna dla wszystkich części tablic, w których nic jeszcze
+// nie zapisano. Nie wolno jej zmieniać.
+static chunk_slot_t empty_page[SLOT_PAGE_SLOTS] = {
+        [0 ... SLOT_PAGE_SLOTS - 1] = {
+                empty_owners, empty_parents, empty_ranks, &empty_chunk
+        }
+};
+
+static chunk_slot_t *slot_at(chunks_t *c, uint32_t number) {
+    return c->table[number >> SLOT_PAGE_BITS] + (number & SLOT_PAGE_MASK);
+}
+
+static void set_slot(chunk_slot_t *slot, chunk_t *chunk, void *data) {
+    slot->chunk = chunk;
+    slot->owners = (uint32_t *) data;
+    slot->parents = (uint64_t *) (slot->owners + CHUNK_FIELDS);
+    slot->ranks = (uint8_t *) (slot->parents + CHUNK_FIELDS);
+}
+
+static bool new_chunk(chunk_slot_t *slot, bool zeroed) {
+    chunk_t *chunk = zeroed ? calloc(1, CHUNK_SIZE) : malloc(CHUNK_SIZE);
+    if (!chunk) {
+        return false;
+    }
+    atomic_init(&chunk->references, 1);
+    chunk->backing = NULL;
+    set_slot(slot, chunk, chunk + 1);
+    return true;
+}
+
+static void free_backing(backing_t *b) {
+    munmap(b->address, b->size);
+    free(b->chunks);
+    free(b);
+}
+
+static void release_backing(backing_t *b) {
+    if (atomic_fetch_sub(&b->references, 1) == 1) {
+        free_backing(b);
+    }
+}
+
+static void release_chunk(chunk_t *chunk) {
+    if (chunk == &empty_chunk ||
+        atomic_fetch_sub(&chunk->references, 1) != 1) {
+        return;
+    }
+    if (!chunk->backing) {
+        free(chunk);
+    } else {
+        release_backing(chunk->backing);
+    }
+}
+
+static bool new_arena(chunks_t *c, int fd) {
+    uint64_t size = (uint64_t) c->count * CHUNK_SIZE;
+    if (fd < 0 && size < ARENA_MIN_SIZE) {
+        return true;
+    }
+    backing_t *b = malloc(sizeof(backing_t));
+    void *address = MAP_FAILED;
+    if (b && fd < 0) {
+        address = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    } else if (b && ftruncate(fd, (off_t) size) == 0) {
+        address = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_NORESERVE, fd, 0);
+    }
+    if (address == MAP_FAILED) {
+        free(b);
+        return fd < 0;
+    }
+#ifdef MADV_HUGEPAGE
+    if (fd < 0) {
+        madvise(address, size, MADV_HUGEPAGE);
+    }
+#endif
+    atomic_init(&b->references, 1);
+    b->address = address;
+    b->size = size;
+    b->chunks = NULL;
+    c->arena = b;
+    return true;
+}
+
+static void arena_chunk(chunks_t *c, chunk_slot_t *slot) {
+    backing_t *b = c->arena;
+    chunk_t *chunk = (chunk_t *) ((char *) b->address +
+                                  (uint64_t) c->arena_used * CHUNK_SIZE);
+    atomic_init(&chunk->references, 1);
+    chunk->backing = b;
+    atomic_fetch_add(&b->references, 1);
+    set_slot(slot, chunk, chunk + 1);
+    c->arena_used++;
+}
+
+static bool new_table(chunks_t *c, uint64_t size) {
+    c->size = size;
+    c->count = (uint32_t) ((size + CHUNK_FIELDS - 1) >> CHUNK_BITS);
+    c->shared = false;
+    c->shared_count = 0;
+    c->shared_marks = NULL;
+    c->arena = NULL;
+    c->arena_used = 0;
+    c->pages = (c->count + SLOT_PAGE_MASK) >> SLOT_PAGE_BITS;
+    c->table = malloc(c->pages * sizeof(chunk_slot_t *));
+    for (uint32_t i = 0; c->table && i < c->pages; i++) {
+        c->table[i] = empty_page;
+    }
+    return c->table != NULL;
+}
+
+static bool own_page(chunks_t *c, uint32_t number) {
+    chunk_slot_t **page = c->table + (number >> SLOT_PAGE_BITS);
+    if (*page != empty_page) {
+        return true;
+    }
+    chunk_slot_t *slots = malloc(SLOT_PAGE_SLOTS * sizeof(chunk_slot_t));
+    if (!slots) {
+        return false;
+    }
+    memcpy(slots, empty_page, SLOT_PAGE_SLOTS * sizeof(chunk_slot_t));
+    *page = slots;
+    return true;
+}
+
+static void free_pages(chunks_t *c) {
+    for (uint32_t i = 0; c->table && i < c->pages; i++) {
+        if (c->table[i] != empty_page) {
+            free(c->table[i]);
+        }
+    }
+    free(c->table);
+    c->table = NULL;
+}
+
+static bool attach(chunks_t *c, uint64_t size, void *address,
+                   uint64_t backing_size, uint64_t owners, uint64_t parents,
+                   uint64_t ranks) {
+    bool table = new_table(c, size);
+    for (uint32_t i = 0; table && i < c->count; i += SLOT_PAGE_SLOTS) {
+        table = own_page(c, i);
+    }
+    backing_t *b = malloc(sizeof(backing_t));
+    chunk_t *chunks = malloc(c->count * sizeof(chunk_t));
+    if (!table || !b || !chunks) {
+        free_pages(c);
+        free(b);
+        free(chunks);
+        return false;
+    }
+    atomic_init(&b->references, c->count);
+    b->address = address;
+    b->size = backing_size;
+    b->chunks = chunks;
+
+    char *data = (char *) address;
+    for (uint32_t i = 0; i < c->count; i++) {
+        uint64_t first = (uint64_t) i << CHUNK_BITS;
+        atomic_init(&chunks[i].references, 1);
+        chunks[i].backing = b;
+        chunk_slot_t *slot = slot_at(c, i);
+        slot->owners = (uint32_t *) (data + owners) + first;
+        slot->parents = (uint64_t *) (data + parents) + first;
+        slot->ranks = (uint8_t *) (data + ranks) + first;
+        slot->chunk = chunks + i;
+    }
+    return true;
+}
+
+bool chunks_init(chunks_t *c, uint64_t size, int fd) {
+    if (!new_table(c, size)) {
+        return false;
+    }
+    if (!new_arena(c, fd)) {
+        free_pages(c);
+        return false;
+    }
+    return true;
+}
+
+bool chunks_map(chunks_t *c, uint64_t size, void *address, uint64_t map_size,
+                uint64_t owners, uint64_t parents, uint64_t ranks) {
+    if (!attach(c, size, address, map_size, owners, parents, ranks)) {
+        munmap(address, map_size);
+        return false;
+    }
+    return true;
+}
+
+static uint64_t *new_marks(chunks_t *c) {
+    return calloc((c->count + 63) / 64, sizeof(uint64_t));
+}
+
+static bool marked(chunks_t *c, uint32_t number) {
+    return c->shared && (c->shared_marks[number / 64] >> number % 64 & 1);
+}
+
+static void set_marks(chunks_t *c, uint64_t *marks) {
+    free(c->shared_marks);
+    c->shared_marks = marks;
+    c->shared_count = 0;
+    for (uint32_t i = 0; i < c->count; i++) {
+        if (c->table[i >> SLOT_PAGE_BITS] == empty_page) {
+            i |= SLOT_PAGE_MASK;
+        } else if (slot_at(c, i)->chunk != &empty_chunk) {
+            marks[i / 64] |= (uint64_t) 1 << i % 64;
+            c->shared_count++;
+        }
+    }
+    c->shared = c->shared_count > 0;
+}
+
+static void unmark(chunks_t *c, uint32_t number) {
+    c->shared_marks[number / 64] &= ~((uint64_t) 1 << number % 64);
+    if (--c->shared_count == 0) {
+        c->shared = false;
+    }
+}
+
+bool chunks_share(chunks_t *c, chunks_t *source) {
+    if (!new_table(c, source->size)) {
+        return false;
+    }
+    uint64_t *marks = new_marks(c);
+    uint64_t *source_marks = new_marks(source);
+    bool pages = marks && source_marks;
+    for (uint32_t i = 0; pages && i < c->pages; i++) {
+        if (source->table[i] != empty_page) {
+            pages = own_page(c, i << SLOT_PAGE_BITS);
+        }
+    }
+    if (!pages) {
+        free(marks);
+        free(source_marks);
+        free_pages(c);
+        return false;
+    }
+    for (uint32_t i = 0; i < c->count; i++) {
+        chunk_slot_t *slot = slot_at(source, i);
+        if (slot->chunk != &empty_chunk) {
+            atomic_fetch_add(&slot->chunk->references, 1);
+            *slot_at(c, i) = *slot;
+        } else if (c->table[i >> SLOT_PAGE_BITS] == empty_page) {
+            i |= SLOT_PAGE_MASK;
+        }
+    }
+    set_marks(c, marks);
+    set_marks(source, source_marks);
+    return true;
+}
+
+void chunks_free(chunks_t *c) {
+    for (uint32_t i = 0; c->table && i < c->count; i++) {
+        if (c->table[i >> SLOT_PAGE_BITS] == empty_page) {
+            i |= SLOT_PAGE_MASK;
+        } else {
+            release_chunk(slot_at(c, i)->chunk);
+        }
+    }
+    if (c->arena) {
+        release_backing(c->arena);
+        c->arena = NULL;
+    }
+    free_pages(c);
+    free(c->shared_marks);
+    c->shared_marks = NULL;
+    c->shared = false;
+    c->count = 0;
+    c->size = 0;
+}
+
+uint32_t chunks_fields(chunks_t *c, uint32_t number) {
+    uint64_t first = (uint64_t) number << CHUNK_BITS;
+    return c->size - first < CHUNK_FIELDS ?
+           (uint32_t) (c->size - first) : CHUNK_FIELDS;
+}
+
+bool chunks_shared(chunks_t *c, uint64_t index) {
+    return c->shared &&
+           atomic_load(&slot_at(c, (uint32_t) (index >> CHUNK_BITS))
+                   ->chunk->references) > 1;
+}
+
+bool chunks_own(chunks_t *c, uint64_t index) {
+    uint32_t number = (uint32_t) (index >> CHUNK_BITS);
+    chunk_slot_t *slot = slot_at(c, number);
+    if (slot->chunk == &empty_chunk) {
+        if (!own_page(c, number)) {
+            return false;
+        }
+        slot = slot_at(c, number);
+        if (c->arena) {
+            arena_chunk(c, slot);
+            return true;
+        }
+        return new_chunk(slot, true);
+    }
+    if (!marked(c, number)) {
+        return true;
+    }
+    if (chunks_shared(c, index)) {
+        chunk_slot_t old = *slot;
+        if (!new_chunk(slot, false)) {
+            return false;
+        }
+        uint32_t fields = chunks_fields(c, number);
+        memcpy(slot->owners, old.owners, fields * sizeof(uint32_t));
+        memcpy(slot->parents, old.parents, fields * sizeof(uint64_t));
+        memcpy(slot->ranks, old.ranks, fields * sizeof(uint8_t));
+        release_chunk(old.chunk);
+    }
+    unmark(c, number);
+    return true;
+}
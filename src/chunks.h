@@ -0,0 +1,180 @@
+/** @file
+ * Współdzielone fragmenty tablic pól planszy gry gamma
+ *
+ * Tablice numerów graczy, rodziców i rang pól podzielone są na fragmenty
+ * po @ref CHUNK_FIELDS kolejnych pól. Fragment może być używany przez kilka
+ * kopii gry jednocześnie i jest kopiowany dopiero wtedy, gdy jedna z nich
+ * chce go zmienić. Liczniki odwołań są atomowe, więc kopie gry mogą być
+ * używane i usuwane w różnych wątkach. Fragmenty nowej planszy są alokowane
+ * dopiero przy pierwszym zapisie, więc pamięć zajmowana przez grę zależy od
+ * liczby zajętych części planszy, a nie od jej rozmiaru.
+ *
+ * @author Szymon Frąckowiak
+ * @date 17.10.2026
+ */
+
+#ifndef GAMMA_CHUNKS_H
+#define GAMMA_CHUNKS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @brief Logarytm dwójkowy liczby pól we fragmencie. */
+#define CHUNK_BITS 12
+
+/** @brief Liczba pól we fragmencie. */
+#define CHUNK_FIELDS ((uint32_t) 1 << CHUNK_BITS)
+
+/** @brief Maska wyznaczająca indeks pola wewnątrz fragmentu. */
+#define CHUNK_MASK (CHUNK_FIELDS - 1)
+
+/** @brief Logarytm dwójkowy liczby opisów fragmentów na stronie tablicy. */
+#define SLOT_PAGE_BITS 10
+
+/** @brief Liczba opisów fragmentów na stronie tablicy fragmentów. */
+#define SLOT_PAGE_SLOTS ((uint32_t) 1 << SLOT_PAGE_BITS)
+
+/** @brief Maska wyznaczająca numer opisu fragmentu wewnątrz strony. */
+#define SLOT_PAGE_MASK (SLOT_PAGE_SLOTS - 1)
+
+/** @brief Struktura opisująca odwzorowaną pamięć, w której leżą fragmenty.
+ * Fragmenty wczytanej gry wskazują na wspólne, ciągłe tablice pól
+ * odwzorowane z pliku z zapisem gry. Fragmenty dużej nowej planszy
+ * zajmują kolejne części anonimowego odwzorowania (areny) w kolejności
+ * pierwszego zapisu, razem ze swoimi strukturami. Odwzorowanie jest
+ * usuwane, gdy zwolniony zostanie ostatni wskazujący na nie fragment,
+ * a w przypadku areny także tablica fragmentów, z której pochodzi.
+ */
+typedef struct backing {
+    atomic_uint references;     ///< liczba fragmentów wskazujących pamięć
+    void *address;              ///< początek pamięci
+    uint64_t size;              ///< rozmiar pamięci
+    struct chunk *chunks;       ///< struktury fragmentów pliku lub NULL
+} backing_t;
+
+/** @brief Struktura przechowująca licznik odwołań do fragmentu tablic pól.
+ * Fragmenty z areny i kopie fragmentów przechowują tablice bezpośrednio za
+ * strukturą, a fragmenty wczytanej gry wskazują na tablice w pliku. Fragment wolno zmieniać
+ * tylko wtedy, gdy ma jedno odwołanie. Wszystkie niezapisane jeszcze
+ * fragmenty nowych gier wskazują na jeden statyczny fragment pustych pól,
+ * którego nie wolno zmieniać i którego licznik odwołań nie jest używany.
+ */
+typedef struct chunk {
+    atomic_uint references;     ///< liczba kopii gry używających fragmentu
+    backing_t *backing;         ///< wspólna pamięć z tablicami lub NULL
+} chunk_t;
+
+/** @brief Struktura opisująca fragment używany przez grę.
+ * Wskaźniki na tablice fragmentu przechowywane są w tablicy fragmentów gry,
+ * a nie w samym fragmencie, dzięki czemu odczyt pola wymaga o jednego
+ * odwołania do pamięci mniej.
+ */
+typedef struct chunk_slot {
+    uint32_t *owners;           ///< numery graczy zajmujących pola
+    uint64_t *parents;          ///< indeksy rodziców pól w obszarach
+    uint8_t *ranks;             ///< rangi pól w obszarach
+    chunk_t *chunk;             ///< licznik odwołań do fragmentu
+} chunk_slot_t;
+
+/** @brief Struktura przechowująca tablicę fragmentów planszy.
+ * Pole o indeksie i leży we fragmencie i >> @ref CHUNK_BITS pod indeksem
+ * i & @ref CHUNK_MASK. Ostatni fragment może być zapełniony tylko częściowo.
+ * Opisy fragmentów podzielone są na strony po @ref SLOT_PAGE_SLOTS opisów.
+ * Wszystkie strony bez zapisanych fragmentów wskazują na jedną statyczną
+ * stronę opisów fragmentu pustych pól, więc nowa plansza zajmuje tylko
+ * tablicę wskaźników na strony, a pamięć na opisy rośnie z liczbą
+ * zapisanych części planszy.
+ * Fragmenty obecne w chwili kopiowania gry są oznaczane jako mogące być
+ * współdzielone, a oznaczenie znika, gdy ta tablica po raz pierwszy
+ * przygotowuje fragment do zmiany. Gdy żaden fragment nie jest już
+ * oznaczony, zmiany przestają sprawdzać liczniki odwołań. Dopóki gra nie
+ * była kopiowana ani nie powstała jako kopia, nie ma oznaczonych fragmentów.
+ */
+typedef struct chunks {
+    uint64_t size;              ///< liczba pól planszy
+    uint32_t count;             ///< liczba fragmentów
+    uint32_t pages;             ///< liczba stron opisów fragmentów
+    bool shared;                ///< czy któryś fragment może być współdzielony
+    uint32_t shared_count;      ///< liczba oznaczonych fragmentów
+    uint64_t *shared_marks;     ///< mapa bitowa oznaczonych fragmentów lub NULL
+    backing_t *arena;           ///< arena na nowe fragmenty lub NULL
+    uint32_t arena_used;        ///< liczba fragmentów wziętych z areny
+    chunk_slot_t **table;       ///< strony opisów kolejnych fragmentów
+} chunks_t;
+
+/** @brief Tworzy fragmenty pustej planszy.
+ * Alokowana jest tylko tablica stron opisów: wszystkie fragmenty wskazują na
+ * fragment pustych pól aż do pierwszego zapisu. Jeśli fragmenty całej
+ * planszy zajęłyby przynajmniej dużą stronę pamięci, to rezerwowana jest
+ * dla nich arena: anonimowe odwzorowanie bez rezerwacji pamięci wymiany
+ * (MAP_NORESERVE) z prośbą o duże strony (MADV_HUGEPAGE). Zapisywane
+ * fragmenty razem ze swoimi strukturami zajmują kolejne części areny, więc
+ * nie trzeba ich alokować ani zerować, a zajęta pamięć i tak rośnie tylko
+ * z liczbą zapisanych fragmentów. Jeśli odwzorowanie się nie uda, fragmenty są alokowane na
+ * stercie. Jeśli podano plik, to arena jest zawsze tworzona jako jego
+ * współdzielone odwzorowanie, a plik jest powiększany do rozmiaru areny
+ * bez zajmowania miejsca na dysku.
+ * @param[out] c      - wskaźnik na inicjowaną tablicę fragmentów,
+ * @param[in] size    - liczba pól planszy,
+ * @param[in] fd      - deskryptor pustego pliku na arenę lub -1.
+ * @return Wartość @p true, jeśli udało się zaalokować pamięć,
+ * a @p false w przeciwnym przypadku.
+ */
+bool chunks_init(chunks_t *c, uint64_t size, int fd);
+
+/** @brief Tworzy fragmenty wskazujące na tablice w odwzorowanym pliku.
+ * Funkcja przejmuje odwzorowanie: jeśli się nie powiedzie, to je usuwa.
+ * @param[out] c          - wskaźnik na inicjowaną tablicę fragmentów,
+ * @param[in] size        - liczba pól planszy,
+ * @param[in] address     - początek odwzorowania,
+ * @param[in] map_size    - rozmiar odwzorowania,
+ * @param[in] owners      - przesunięcie tablicy numerów graczy,
+ * @param[in] parents     - przesunięcie tablicy rodziców,
+ * @param[in] ranks       - przesunięcie tablicy rang.
+ * @return Wartość @p true, jeśli udało się zaalokować pamięć,
+ * a @p false w przeciwnym przypadku.
+ */
+bool chunks_map(chunks_t *c, uint64_t size, void *address, uint64_t map_size,
+                uint64_t owners, uint64_t parents, uint64_t ranks);
+
+/** @brief Tworzy tablicę fragmentów współdzielącą wszystkie fragmenty.
+ * W obu tablicach oznaczane są wszystkie zapisane już fragmenty.
+ * @param[out] c          - wskaźnik na inicjowaną tablicę fragmentów,
+ * @param[in,out] source  - wskaźnik na kopiowaną tablicę fragmentów.
+ * @return Wartość @p true, jeśli udało się zaalokować pamięć,
+ * a @p false w przeciwnym przypadku.
+ */
+bool chunks_share(chunks_t *c, chunks_t *source);
+
+/** @brief Zwalnia odwołania do wszystkich fragmentów.
+ * @param[in,out] c   - wskaźnik na tablicę fragmentów.
+ */
+void chunks_free(chunks_t *c);
+
+/** @brief Zwraca liczbę pól we fragmencie.
+ * @param[in] c       - wskaźnik na tablicę fragmentów,
+ * @param[in] number  - numer fragmentu.
+ */
+uint32_t chunks_fields(chunks_t *c, uint32_t number);
+
+/** @brief Zapewnia, że fragment z danym polem można zmieniać.
+ * Jeśli fragment jest współdzielony, to zastępuje go prywatną kopią, a jeśli
+ * jest fragmentem pustych pól, to alokuje nowy, wyzerowany fragment.
+ * Usuwa oznaczenie fragmentu jako mogącego być współdzielonym.
+ * @param[in,out] c   - wskaźnik na tablicę fragmentów,
+ * @param[in] index   - indeks pola.
+ * @return Wartość @p true, jeśli fragment można zmieniać, a @p false,
+ * jeśli nie udało się zaalokować pamięci na kopię.
+ */
+bool chunks_own(chunks_t *c, uint64_t index);
+
+/** @brief Sprawdza, czy fragment z danym polem jest współdzielony.
+ * @param[in] c       - wskaźnik na tablicę fragmentów,
+ * @param[in] index   - indeks pola.
+ * @return Wartość @p true, jeśli fragmentu używa więcej niż jedna kopia gry,
+ * a @p false w przeciwnym przypadku.
+ */
+bool chunks_shared(chunks_t *c, uint64_t index);
+
+#endif //GAMMA_CHUNKS_H
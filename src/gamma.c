@@ -1,8 +1,19 @@
+#define _GNU_SOURCE
+
 #include "gamma.h"
+#include "journal.h"
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
 
-gamma_t *gamma_new(uint32_t width, uint32_t height,
-                   uint32_t players, uint32_t areas) {
-    if (width < 1 || height < 1 || players < 1 || areas < 1) {
+#define BOARD_CHUNK_SIZE 65536
+
+static gamma_t *new_game(uint32_t width, uint32_t height, uint32_t players,
+                         uint32_t areas, gamma_topology_t topology,
+                         uint64_t max_fields, int fd) {
+    if (width < 1 || height < 1 || players < 1 || areas < 1 ||
+        (unsigned) topology >= GAMMA_TOPOLOGIES ||
+        (uint64_t) width * height > max_fields) {
         return NULL;
     }
     gamma_t *g = (gamma_t *) calloc(1, sizeof(gamma_t));
@@ -14,8 +25,15 @@ gamma_t *gamma_new(uint32_t width, uint32_t height,
         free(g);
         return NULL;
     }
-    field_t *new_board = (field_t *) calloc((uint64_t) width * height, sizeof(field_t));
-    if (!new_board) {
+    if (!chunks_init(&g->chunks, (uint64_t) width * height, fd)) {
+        free(g);
+        free(new_players);
+        return NULL;
+    }
+    // Mapy bitowe opisują tylko sąsiedztwo bokami w zwykłej siatce.
+    if (topology == GAMMA_SQUARE &&
+        !bitplanes_init(&g->planes, width, height, players)) {
+        chunks_free(&g->chunks);
         free(g);
         free(new_players);
         return NULL;
@@ -23,57 +41,149 @@ gamma_t *gamma_new(uint32_t width, uint32_t height,
     for (uint32_t i = 0; i < players; i++) {
         new_players[i].id = 1 + i;
     }
-    for (uint64_t i = 0; i < (uint64_t) width * height; i++) {
-        (new_board + i)->player = NULL;
-    }
     g->board_width = width;
     g->board_height = height;
     g->number_of_players = players;
     g->active_players = 0;
     g->max_areas = areas;
-    g->last_update_time = 1;
     g->all_free_fields = (uint64_t) width * height;
     g->players = new_players;
-    g->board = new_board;
+    g->topology = (uint8_t) topology;
+    set_neighbours(g);
     return g;
 }
 
+gamma_t *gamma_new(uint32_t width, uint32_t height,
+                   uint32_t players, uint32_t areas) {
+    return new_game(width, height, players, areas, GAMMA_SQUARE, UINT32_MAX,
+                    -1);
+}
+
+gamma_t *gamma_new_topology(uint32_t width, uint32_t height, uint32_t players,
+                            uint32_t areas, gamma_topology_t topology) {
+    return new_game(width, height, players, areas, topology, UINT32_MAX, -1);
+}
+
+gamma_t *gamma_new_file(const char *path, uint32_t width, uint32_t height,
+                        uint32_t players, uint32_t areas) {
+    if (path == NULL) {
+        return NULL;
+    }
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        return NULL;
+    }
+    gamma_t *g = new_game(width, height, players, areas, GAMMA_SQUARE,
+                          MAX_FIELDS, fd);
+    unlink(path);
+    close(fd);
+    return g;
+}
+
+gamma_t *gamma_clone(gamma_t *g) {
+    if (g == NULL) {
+        return NULL;
+    }
+    gamma_t *clone = (gamma_t *) calloc(1, sizeof(gamma_t));
+    if (!clone) {
+        return NULL;
+    }
+    clone->players = (player_t *) malloc(g->number_of_players *
+                                         sizeof(player_t));
+    if (!clone->players) {
+        free(clone);
+        return NULL;
+    }
+    if (!chunks_share(&clone->chunks, &g->chunks)) {
+        free(clone->players);
+        free(clone);
+        return NULL;
+    }
+    if (!bitplanes_share(&clone->planes, &g->planes)) {
+        chunks_free(&clone->chunks);
+        free(clone->players);
+        free(clone);
+        return NULL;
+    }
+    memcpy(clone->players, g->players, g->number_of_players * sizeof(player_t));
+    clone->board_width = g->board_width;
+    clone->board_height = g->board_height;
+    clone->number_of_players = g->number_of_players;
+    clone->active_players = g->active_players;
+    clone->max_areas = g->max_areas;
+    clone->all_free_fields = g->all_free_fields;
+    clone->topology = g->topology;
+    set_neighbours(clone);
+    return clone;
+}
+
 void gamma_delete(gamma_t *g) {
     if (!g) {
         return;
     }
     free(g->players);
-    free(g->board);
+    chunks_free(&g->chunks);
+    bitplanes_free(&g->planes);
+    free_scratch(&g->scratch);
+    journal_stop(g);
     free(g);
 }
 
+static void place_field(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
+    update_owner(g, x, y, player);
+    player_t *p = edit_player(g, player);
+    if (p->busy_fields == 0) {
+        g->active_players += 1;
+    }
+    p->busy_fields += 1;
+    p->busy_areas += 1;
+    add_always_free(g, x, y);
+    merge_with_areas(g, x, y);
+    g->all_free_fields -= 1;
+}
+
+static void make_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
+    journal_begin(g, JOURNAL_MOVE, player, x, y);
+    place_field(g, player, x, y);
+}
+
+static bool golden_move_ready(gamma_t *g, uint32_t player,
+                              uint32_t x, uint32_t y) {
+    player_t *owner = get_player(g, get_owner(g, x, y));
+    return reserve_scratch(g, &g->scratch, owner->busy_fields) &&
+           own_removal(g, x, y) && own_placement(g, player, x, y);
+}
+
+static void make_golden_move(gamma_t *g, uint32_t player,
+                             uint32_t x, uint32_t y) {
+    journal_begin(g, JOURNAL_GOLDEN_MOVE, player, x, y);
+    remove_field(g, x, y);
+    place_field(g, player, x, y);
+    edit_player(g, player)->golden_move_used = true;
+}
+
 bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
     if (g == NULL || player < 1 || player > g->number_of_players ||
         x >= g->board_width || y >= g->board_height) {
         return false;
     }
-    field_t *f = get_field(g, x, y);
-    if (f->player != NULL) {
+    if (get_owner(g, x, y) != 0) {
         return false;
     }
 
     player_t *p = get_player(g, player);
 
     if (p->busy_areas >= g->max_areas &&
-        count_same_players(g, x, y, p, 0) == 0) {
+        count_same_players(g, x, y, player, 0) == 0) {
         return false;
     }
 
-    f->player = p;
-    if (p->busy_fields == 0) {
-        g->active_players += 1;
+    if (!own_placement(g, player, x, y)) {
+        return false;
     }
-    p->busy_fields += 1;
-    p->busy_areas += 1;
-    add_always_free(g, x, y);
-    merge_with_areas(g, x, y);
-    g->all_free_fields -= 1;
 
+    journal_forget_redo(g);
+    make_move(g, player, x, y);
     return true;
 }
 
@@ -87,15 +197,16 @@ bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
         return false;
     }
 
-    if (!gm_field_possible(g, player, x, y)) {
+    if (!gm_field_possible(g, &g->scratch, player, x, y)) {
         return false;
     }
 
-    remove_field(g, x, y);
-    gamma_move(g, player, x, y);
-
-    get_player(g, player)->golden_move_used = true;
+    if (!golden_move_ready(g, player, x, y)) {
+        return false;
+    }
 
+    journal_forget_redo(g);
+    make_golden_move(g, player, x, y);
     return true;
 }
 
@@ -118,7 +229,24 @@ uint64_t gamma_free_fields(gamma_t *g, uint32_t player) {
 }
 
 bool gamma_golden_possible(gamma_t *g, uint32_t player) {
-    if (g == NULL || player < 1 || player > g->number_of_players) {
+    return g != NULL && gamma_golden_possible_with(g, player, &g->scratch);
+}
+
+gamma_scratch_t *gamma_scratch_new(void) {
+    return (gamma_scratch_t *) calloc(1, sizeof(gamma_scratch_t));
+}
+
+void gamma_scratch_delete(gamma_scratch_t *s) {
+    if (s != NULL) {
+        free_scratch(s);
+        free(s);
+    }
+}
+
+bool gamma_golden_possible_with(gamma_t *g, uint32_t player,
+                                gamma_scratch_t *s) {
+    if (g == NULL || s == NULL || player < 1 ||
+        player > g->number_of_players) {
         return false;
     }
 
@@ -126,67 +254,222 @@ bool gamma_golden_possible(gamma_t *g, uint32_t player) {
         return false;
     }
 
-    for (uint32_t y = 0; y < g->board_height; y++) {
-        for (uint32_t x = 0; x < g->board_width; x++) {
-            if (gm_field_possible(g, player, x, y)) {
-                return true;
-            }
+    bool result;
+    if (gm_possible_fast(g, player, &result)) {
+        return result;
+    }
+
+    return gm_border_possible(g, s, player);
+}
+
+bool gamma_golden_possible_all(gamma_t *g, bool *result) {
+    if (g == NULL || result == NULL) {
+        return false;
+    }
+
+    bool *pending = calloc(g->number_of_players, sizeof(bool));
+    uint32_t count = 0;
+    for (uint32_t player = 1; player <= g->number_of_players; player++) {
+        bool fast;
+        result[player - 1] = false;
+        if (!gm_necessary(g, player)) {
+            continue;
+        }
+        if (gm_possible_fast(g, player, &fast)) {
+            result[player - 1] = fast;
+        } else if (pending) {
+            pending[player - 1] = true;
+            count++;
+        } else {
+            result[player - 1] = gm_border_possible(g, &g->scratch, player);
         }
     }
-    return false;
+
+    if (count > 0) {
+        gm_border_possible_all(g, &g->scratch, pending, count, result);
+    }
+    free(pending);
+    return true;
 }
 
-char *gamma_board(gamma_t *g) {
+bool gamma_stats_all(gamma_t *g, gamma_stats_t *out) {
+    if (g == NULL || out == NULL) {
+        return false;
+    }
+
+    bool *golden = malloc(g->number_of_players * sizeof(bool));
+    if (golden) {
+        gamma_golden_possible_all(g, golden);
+    }
+    for (uint32_t player = 1; player <= g->number_of_players; player++) {
+        player_t *p = get_player(g, player);
+        gamma_stats_t *s = out + player - 1;
+        s->busy_fields = p->busy_fields;
+        s->free_fields = gamma_free_fields(g, player);
+        s->areas = p->busy_areas;
+        s->golden_possible = golden ? golden[player - 1] :
+                             gamma_golden_possible(g, player);
+    }
+    free(golden);
+    return true;
+}
+
+void gamma_counters_enable(gamma_t *g, bool enabled) {
     if (g == NULL) {
+        return;
+    }
+    if (enabled) {
+        memset(&g->counters, 0, sizeof(gamma_counters_t));
+    }
+    g->counting = enabled;
+}
+
+bool gamma_counters(gamma_t *g, gamma_counters_t *out) {
+    if (g == NULL || out == NULL) {
+        return false;
+    }
+    *out = g->counters;
+    return true;
+}
+
+char *gamma_board(gamma_t *g) {
+    uint64_t board_size = gamma_board_size(g);
+    if (board_size == 0 || board_size > SIZE_MAX) {
         return NULL;
     }
 
-    uint32_t field_width = get_field_size(g->number_of_players);
-    size_t board_size = (g->board_width * field_width + 1) * g->board_height + 1;
     char *board_display = malloc(board_size * sizeof(char));
-
     if (board_display == NULL) {
         return NULL;
     }
 
-    uint64_t i = 0;
-    for (uint32_t y = (g->board_height); y > 0; y--) {
-        for (uint32_t x = 0; x < g->board_width; x++) {
-            if (get_field(g, x, y - 1)->player == NULL) {
-                for (uint32_t j = 0; j < field_width - 1; j++) {
-                    board_display[i] = '_';
-                    i++;
-                }
-                board_display[i] = '.';
-                i++;
-            } else {
-                uint32_t player_number = get_field(g, x, y - 1)->player->id;
-                uint32_t digits_number = get_field_size(player_number);
-
-                for (uint32_t j = 0; j < field_width - digits_number; j++) {
-                    board_display[i] = '_';
-                    i++;
-                }
+    gamma_board_into(g, board_display, board_size);
+    return board_display;
+}
 
-                char *string_int = malloc((digits_number + 1) * sizeof(char));
+uint64_t gamma_board_size(gamma_t *g) {
+    if (g == NULL) {
+        return 0;
+    }
 
-                if (string_int == NULL) {
-                    free(board_display);
-                    return NULL;
-                }
+    uint64_t field_width = get_field_size(g->number_of_players);
+    return (g->board_width * field_width + 1) * g->board_height + 1;
+}
 
-                sprintf(string_int, "%u", player_number);
+bool gamma_board_into(gamma_t *g, char *buffer, uint64_t length) {
+    if (g == NULL) {
+        return false;
+    }
+    return gamma_board_window_into(g, 0, 0, g->board_width, g->board_height,
+                                   buffer, length);
+}
 
-                for (uint32_t j = 0; j < digits_number; j++) {
-                    board_display[i] = string_int[j];
-                    i++;
+uint64_t gamma_board_window_size(gamma_t *g, uint32_t width, uint32_t height) {
+    if (g == NULL) {
+        return 0;
+    }
+
+    uint64_t field_width = get_field_size(g->number_of_players);
+    return (width * field_width + 1) * height + 1;
+}
+
+bool gamma_board_window_into(gamma_t *g, uint32_t x, uint32_t y,
+                             uint32_t width, uint32_t height,
+                             char *buffer, uint64_t length) {
+    if (g == NULL || buffer == NULL ||
+        width > g->board_width || x > g->board_width - width ||
+        height > g->board_height || y > g->board_height - height ||
+        length < gamma_board_window_size(g, width, height)) {
+        return false;
+    }
+
+    uint32_t field_width = get_field_size(g->number_of_players);
+    for (uint32_t row = y + height; row > y; row--) {
+        buffer = write_row(g, buffer, field_width, x, x + width, row - 1);
+        *buffer++ = '\n';
+    }
+    *buffer = '\0';
+    return true;
+}
+
+static bool write_chunk(FILE *file, const char *chunk, const char *end) {
+    size_t length = (size_t) (end - chunk);
+    return fwrite(chunk, sizeof(char), length, file) == length;
+}
+
+bool gamma_board_write(gamma_t *g, FILE *file) {
+    if (g == NULL || file == NULL) {
+        return false;
+    }
+
+    char chunk[BOARD_CHUNK_SIZE];
+    const char *limit = chunk + BOARD_CHUNK_SIZE - 1;
+    uint32_t field_width = get_field_size(g->number_of_players);
+    char *end = chunk;
+
+    for (uint32_t y = g->board_height; y > 0; y--) {
+        uint32_t x = 0;
+        while (x < g->board_width) {
+            uint32_t fields = 0;
+            if (end < limit) {
+                fields = (uint32_t) (limit - end) / field_width;
+            }
+            if (fields == 0) {
+                if (!write_chunk(file, chunk, end)) {
+                    return false;
                 }
-                free(string_int);
+                end = chunk;
+                continue;
+            }
+            if (fields > g->board_width - x) {
+                fields = g->board_width - x;
             }
+            end = write_row(g, end, field_width, x, x + fields, y - 1);
+            x += fields;
         }
-        board_display[i] = '\n';
-        i++;
+        *end++ = '\n';
     }
-    board_display[i] = '\0';
-    return board_display;
+    return write_chunk(file, chunk, end);
+}
+
+bool gamma_journal_start(gamma_t *g) {
+    return g != NULL && journal_start(g);
+}
+
+void gamma_journal_stop(gamma_t *g) {
+    if (g != NULL) {
+        journal_stop(g);
+    }
+}
+
+bool gamma_undo(gamma_t *g) {
+    journal_entry_t move;
+    if (g == NULL || !journal_undo(g, &move)) {
+        return false;
+    }
+    journal_push_redo(g, move);
+    return true;
+}
+
+bool gamma_redo(gamma_t *g) {
+    journal_entry_t move;
+    if (g == NULL || !journal_pop_redo(g, &move)) {
+        return false;
+    }
+
+    uint32_t x = (uint32_t) (move.value >> 32);
+    uint32_t y = (uint32_t) move.value;
+    bool ready = move.kind == JOURNAL_GOLDEN_MOVE ?
+                 golden_move_ready(g, move.index, x, y) :
+                 own_placement(g, move.index, x, y);
+    if (!ready) {
+        journal_push_redo(g, move);
+        return false;
+    }
+    if (move.kind == JOURNAL_GOLDEN_MOVE) {
+        make_golden_move(g, move.index, x, y);
+    } else {
+        make_move(g, move.index, x, y);
+    }
+    return true;
 }
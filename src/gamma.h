@@ -11,6 +11,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include "helper-f.h"
 
 /**
@@ -18,6 +19,39 @@
  */
 typedef struct gamma gamma_t;
 
+/**
+ * Struktura przechowująca statystyki jednego gracza.
+ */
+typedef struct gamma_stats {
+    uint64_t busy_fields;       ///< wynik @ref gamma_busy_fields
+    uint64_t free_fields;       ///< wynik @ref gamma_free_fields
+    uint64_t areas;             ///< liczba obszarów zajętych przez gracza
+    bool golden_possible;       ///< wynik @ref gamma_golden_possible
+} gamma_stats_t;
+
+/**
+ * Struktura przechowująca liczniki operacji silnika gry.
+ */
+typedef struct gamma_counters gamma_counters_t;
+
+/**
+ * Struktura przechowująca bufory pomocnicze sprawdzania złotego ruchu.
+ */
+typedef struct scratch gamma_scratch_t;
+
+/**
+ * Topologia planszy, czyli to, które pola ze sobą sąsiadują.
+ */
+typedef enum gamma_topology {
+    GAMMA_SQUARE,       ///< zwykła siatka, sąsiedzi po bokach pola
+    GAMMA_TORUS,        ///< zwykła siatka ze sklejonymi przeciwległymi brzegami
+    GAMMA_HEX,          ///< siatka sześciokątów, nieparzyste wiersze przesunięte
+                        ///< o pół pola w prawo
+    GAMMA_KING,         ///< siatka, w której sąsiadują też pola stykające się
+                        ///< rogiem
+    GAMMA_TOPOLOGIES    ///< liczba topologii
+} gamma_topology_t;
+
 /** @brief Tworzy strukturę przechowującą stan gry.
  * Alokuje pamięć na nową strukturę przechowującą stan gry.
  * Inicjuje tę strukturę tak, aby reprezentowała początkowy stan gry.
@@ -32,6 +66,50 @@ typedef struct gamma gamma_t;
 gamma_t *gamma_new(uint32_t width, uint32_t height,
                    uint32_t players, uint32_t areas);
 
+/** @brief Tworzy grę na planszy o danej topologii.
+ * Działa jak @ref gamma_new, ale obszary, wolne pola i złote ruchy liczone
+ * są według sąsiedztwa pól w podanej topologii. Na siatce sześciokątów
+ * pole (x, y) sąsiaduje z polami (x - 1, y) i (x + 1, y) oraz z dwoma
+ * polami w wierszu powyżej i dwoma w wierszu poniżej: w wierszach parzystych
+ * z kolumnami x - 1 i x, a w nieparzystych z kolumnami x i x + 1. Gra
+ * utworzona przez @ref gamma_new ma topologię @ref GAMMA_SQUARE.
+ * @param[in] width   – szerokość planszy, liczba dodatnia,
+ * @param[in] height  – wysokość planszy, liczba dodatnia,
+ * @param[in] players – liczba graczy, liczba dodatnia,
+ * @param[in] areas   – maksymalna liczba obszarów,
+ *                      jakie może zająć jeden gracz,
+ * @param[in] topology – topologia planszy.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * zaalokować pamięci lub któryś z parametrów jest niepoprawny.
+ */
+gamma_t *gamma_new_topology(uint32_t width, uint32_t height, uint32_t players,
+                            uint32_t areas, gamma_topology_t topology);
+
+/** @brief Tworzy grę, której plansza przechowywana jest w pliku.
+ * Działa jak @ref gamma_new, ale tablice pól planszy leżą w nowym pliku
+ * odwzorowanym w pamięci, więc system może usuwać z pamięci nieużywane
+ * części planszy i zapisywać je w pliku. Plik jest rzadki: miejsce na dysku
+ * zajmują tylko fragmenty planszy, w których coś zapisano. Plik jest
+ * usuwany z katalogu od razu po utworzeniu, więc znika razem z grą.
+ * Plansza może mieć do @ref MAX_FIELDS, czyli 2^40 pól, a nie tylko do
+ * UINT32_MAX jak w @ref gamma_new. Plik ma wtedy około 13 TiB, więc system
+ * plików musi dopuszczać tak duże pliki rzadkie. Pamięć na opisy
+ * fragmentów rośnie z liczbą zapisanych części planszy, a nie z jej
+ * rozmiarem. Mapy bitowe i bufory przeszukiwań obszarów pozostają
+ * w zwykłej pamięci.
+ * @param[in] path    – ścieżka do pliku, który nie może istnieć,
+ * @param[in] width   – szerokość planszy, liczba dodatnia,
+ * @param[in] height  – wysokość planszy, liczba dodatnia,
+ * @param[in] players – liczba graczy, liczba dodatnia,
+ * @param[in] areas   – maksymalna liczba obszarów,
+ *                      jakie może zająć jeden gracz.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * utworzyć pliku lub zaalokować pamięci albo któryś z parametrów jest
+ * niepoprawny.
+ */
+gamma_t *gamma_new_file(const char *path, uint32_t width, uint32_t height,
+                        uint32_t players, uint32_t areas);
+
 /** @brief Usuwa strukturę przechowującą stan gry.
  * Usuwa z pamięci strukturę wskazywaną przez @p g.
  * Nic nie robi, jeśli wskaźnik ten ma wartość NULL.
@@ -39,6 +117,20 @@ gamma_t *gamma_new(uint32_t width, uint32_t height,
  */
 void gamma_delete(gamma_t *g);
 
+/** @brief Tworzy niezależną kopię stanu gry.
+ * Kopia współdzieli z oryginałem fragmenty planszy, a fragment jest
+ * kopiowany dopiero wtedy, gdy któraś z gier chce go zmienić. Utworzenie
+ * kopii kosztuje więc tylko tyle, co skopiowanie liczników graczy i tablicy
+ * wskaźników na fragmenty. Kopia nie przejmuje dziennika ruchów. Kopie
+ * jednej gry mogą być używane i usuwane w różnych wątkach, ale funkcja
+ * oznacza kopiowaną grę jako współdzielącą fragmenty, więc nie wolno jej
+ * wywoływać jednocześnie z innymi funkcjami dla tej samej gry.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * zaalokować pamięci lub @p g ma wartość NULL.
+ */
+gamma_t *gamma_clone(gamma_t *g);
+
 /** @brief Wykonuje ruch.
  * Ustawia pionek gracza @p player na polu (@p x, @p y).
  * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
@@ -49,7 +141,8 @@ void gamma_delete(gamma_t *g);
  * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
  *                      @p height z funkcji @ref gamma_new.
  * @return Wartość @p true, jeśli ruch został wykonany, a @p false,
- * gdy ruch jest nielegalny lub któryś z parametrów jest niepoprawny.
+ * gdy ruch jest nielegalny, któryś z parametrów jest niepoprawny lub nie
+ * udało się skopiować fragmentu planszy współdzielonego z inną kopią gry.
  */
 bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
 
@@ -64,8 +157,8 @@ bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
  * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
  *                      @p height z funkcji @ref gamma_new.
  * @return Wartość @p true, jeśli ruch został wykonany, a @p false,
- * gdy gracz wykorzystał już swój złoty ruch, ruch jest nielegalny
- * lub któryś z parametrów jest niepoprawny.
+ * gdy gracz wykorzystał już swój złoty ruch, ruch jest nielegalny,
+ * któryś z parametrów jest niepoprawny lub nie udało się zaalokować pamięci.
  */
 bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
 
@@ -93,6 +186,9 @@ uint64_t gamma_free_fields(gamma_t *g, uint32_t player);
 /** @brief Sprawdza, czy gracz może wykonać złoty ruch.
  * Sprawdza, czy gracz @p player jeszcze nie wykonał w tej rozgrywce złotego
  * ruchu i czy możliwe jest
+ * Używa buforów pomocniczych przechowywanych w grze, więc zmienia jej stan
+ * i nie wolno jej wywoływać dla tej samej gry w kilku wątkach jednocześnie
+ * (zob. @ref gamma_golden_possible_with).
  * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
  * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
  *                      @p players z funkcji @ref gamma_new.
@@ -102,6 +198,87 @@ uint64_t gamma_free_fields(gamma_t *g, uint32_t player);
  */
 bool gamma_golden_possible(gamma_t *g, uint32_t player);
 
+/** @brief Tworzy bufory pomocnicze sprawdzania złotego ruchu.
+ * Bufory są puste i rosną przy pierwszych sprawdzeniach. Można ich używać
+ * kolejno dla różnych gier.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * zaalokować pamięci.
+ */
+gamma_scratch_t *gamma_scratch_new(void);
+
+/** @brief Usuwa bufory pomocnicze sprawdzania złotego ruchu.
+ * Nic nie robi, jeśli wskaźnik ma wartość NULL.
+ * @param[in] s       – wskaźnik na usuwaną strukturę.
+ */
+void gamma_scratch_delete(gamma_scratch_t *s);
+
+/** @brief Sprawdza, czy gracz może wykonać złoty ruch, używając podanych
+ * buforów.
+ * Daje taki sam wynik jak @ref gamma_golden_possible, ale zamiast buforów
+ * pomocniczych przechowywanych w grze używa buforów @p s i nie zmienia
+ * stanu gry. Dopóki żaden wątek nie zmienia gry i liczniki operacji są
+ * wyłączone, wiele wątków może sprawdzać tę samą grę jednocześnie, każdy
+ * z własnymi buforami.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in,out] s   – wskaźnik na bufory pomocnicze.
+ * @return Wartość @p true, jeśli gracz może wykonać złoty ruch, a @p false
+ * w przeciwnym przypadku lub gdy nie udało się zaalokować pamięci.
+ */
+bool gamma_golden_possible_with(gamma_t *g, uint32_t player,
+                                gamma_scratch_t *s);
+
+/** @brief Sprawdza, którzy gracze mogą wykonać złoty ruch.
+ * Daje dla każdego gracza taki sam wynik jak @ref gamma_golden_possible,
+ * ale pola na granicach wszystkich graczy przegląda jednym przejściem przez
+ * planszę, a możliwość usunięcia pionka z pola sprawdza raz dla wszystkich
+ * graczy sąsiadujących z tym polem. Podobnie jak @ref gamma_golden_possible
+ * używa buforów pomocniczych przechowywanych w grze.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] result – tablica o długości równej wartości @p players
+ *                      z funkcji @ref gamma_new, w której pod indeksem
+ *                      i zapisywany jest wynik dla gracza i + 1.
+ * @return Wartość @p true, jeśli tablica została wypełniona, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny.
+ */
+bool gamma_golden_possible_all(gamma_t *g, bool *result);
+
+/** @brief Podaje statystyki wszystkich graczy.
+ * Dla każdego gracza zapisuje liczbę zajętych pól, liczbę pól, jakie jeszcze
+ * może zająć, liczbę zajętych obszarów i możliwość wykonania złotego ruchu.
+ * Złoty ruch sprawdzany jest dla wszystkich graczy naraz, tak jak w funkcji
+ * @ref gamma_golden_possible_all.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] out    – tablica o długości równej wartości @p players
+ *                      z funkcji @ref gamma_new, w której pod indeksem
+ *                      i zapisywane są statystyki gracza i + 1.
+ * @return Wartość @p true, jeśli tablica została wypełniona, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny.
+ */
+bool gamma_stats_all(gamma_t *g, gamma_stats_t *out);
+
+/** @brief Włącza lub wyłącza liczniki operacji silnika.
+ * Liczniki są domyślnie wyłączone, a włączenie ich zeruje. Wyłączone
+ * liczniki zachowują zebrane wartości. Włączone liczniki zwiększają także
+ * funkcje sprawdzające złoty ruch, więc wtedy również
+ * @ref gamma_golden_possible_with z osobnymi buforami zmienia stan gry i nie
+ * może być wywoływana dla tej samej gry w kilku wątkach jednocześnie.
+ * Pozostałe funkcje sprawdzające złoty ruch zmieniają stan gry zawsze.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] enabled – czy liczniki mają być zwiększane.
+ */
+void gamma_counters_enable(gamma_t *g, bool enabled);
+
+/** @brief Podaje liczniki operacji silnika.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] out    – wskaźnik na strukturę, do której zapisywane są
+ *                      liczniki zebrane od ich włączenia.
+ * @return Wartość @p true, jeśli liczniki zostały zapisane, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny.
+ */
+bool gamma_counters(gamma_t *g, gamma_counters_t *out);
+
 /** @brief Daje napis opisujący stan planszy.
  * Alokuje w pamięci bufor, w którym umieszcza napis zawierający tekstowy
  * opis aktualnego stanu planszy. Przykład znajduje się w pliku gamma_test.c.
@@ -112,4 +289,121 @@ bool gamma_golden_possible(gamma_t *g, uint32_t player);
  */
 char *gamma_board(gamma_t *g);
 
+/** @brief Podaje rozmiar napisu opisującego stan planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Liczba bajtów potrzebna do zapisania napisu zwracanego przez
+ * @ref gamma_board, łącznie z kończącym znakiem '\0', lub zero,
+ * jeśli parametr jest niepoprawny.
+ */
+uint64_t gamma_board_size(gamma_t *g);
+
+/** @brief Zapisuje napis opisujący stan planszy do podanego bufora.
+ * Działa jak @ref gamma_board, ale nie alokuje pamięci. Napis, łącznie
+ * z kończącym znakiem '\0', umieszczany jest w buforze dostarczonym przez
+ * funkcję wywołującą, który można wykorzystywać wielokrotnie.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] buffer – wskaźnik na bufor,
+ * @param[in] length  – rozmiar bufora w bajtach.
+ * @return Wartość @p true, jeśli napis został zapisany, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny lub bufor jest za mały,
+ * by pomieścić napis.
+ */
+bool gamma_board_into(gamma_t *g, char *buffer, uint64_t length);
+
+/** @brief Podaje rozmiar napisu opisującego prostokątny fragment planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] width   – liczba kolumn fragmentu,
+ * @param[in] height  – liczba wierszy fragmentu.
+ * @return Liczba bajtów potrzebna do zapisania napisu tworzonego przez
+ * @ref gamma_board_window_into, łącznie z kończącym znakiem '\0', lub zero,
+ * jeśli parametr @p g jest niepoprawny.
+ */
+uint64_t gamma_board_window_size(gamma_t *g, uint32_t width, uint32_t height);
+
+/** @brief Zapisuje napis opisujący prostokątny fragment planszy.
+ * Działa jak @ref gamma_board_into, ale opisuje tylko pola o numerach kolumn
+ * od @p x do @p x + @p width - 1 i numerach wierszy od @p y do
+ * @p y + @p height - 1, więc jego koszt zależy od rozmiaru fragmentu,
+ * a nie całej planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer pierwszej kolumny fragmentu,
+ * @param[in] y       – numer pierwszego wiersza fragmentu,
+ * @param[in] width   – liczba kolumn fragmentu,
+ * @param[in] height  – liczba wierszy fragmentu,
+ * @param[out] buffer – wskaźnik na bufor,
+ * @param[in] length  – rozmiar bufora w bajtach.
+ * @return Wartość @p true, jeśli napis został zapisany, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny, fragment wykracza poza planszę
+ * lub bufor jest za mały, by pomieścić napis.
+ */
+bool gamma_board_window_into(gamma_t *g, uint32_t x, uint32_t y,
+                             uint32_t width, uint32_t height,
+                             char *buffer, uint64_t length);
+
+/** @brief Wypisuje napis opisujący stan planszy do strumienia.
+ * Wypisuje do strumienia @p file ten sam napis, który zwraca
+ * @ref gamma_board, bez kończącego znaku '\0'. Napis tworzony jest
+ * fragmentami w buforze o stałym rozmiarze, więc zużycie pamięci nie zależy
+ * od rozmiaru planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] file    – strumień, do którego wypisywana jest plansza.
+ * @return Wartość @p true, jeśli plansza została wypisana, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny lub zapis się nie powiódł.
+ */
+bool gamma_board_write(gamma_t *g, FILE *file);
+
+/** @brief Zapisuje stan gry do pliku.
+ * Zapisuje planszę, stan obszarów i liczniki graczy w formacie binarnym
+ * opisanym w pliku snapshot.h, z którego @ref gamma_load odtwarza grę bez
+ * ponownego wykonywania ruchów.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] path    – ścieżka do tworzonego pliku.
+ * @return Wartość @p true, jeśli stan gry został zapisany, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny lub zapis się nie powiódł.
+ */
+bool gamma_save(gamma_t *g, const char *path);
+
+/** @brief Odtwarza stan gry z pliku.
+ * Tablice pól planszy nie są wczytywane, lecz odwzorowywane w pamięci
+ * prywatnie, więc dalsza gra nie zmienia zawartości pliku.
+ * @param[in] path    – ścieżka do pliku utworzonego przez @ref gamma_save.
+ * @return Wskaźnik na strukturę przechowującą stan gry lub NULL, gdy plik
+ * nie istnieje, jest niepoprawny lub nie udało się zaalokować pamięci.
+ */
+gamma_t *gamma_load(const char *path);
+
+/** @brief Włącza dziennik ruchów.
+ * Od tej chwili każdy udany ruch i złoty ruch zapisuje w dzienniku zmiany,
+ * które wprowadził, dzięki czemu można go cofnąć funkcją @ref gamma_undo.
+ * Ruchy wykonane przed włączeniem dziennika nie mogą zostać cofnięte.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli dziennik jest włączony, a @p false,
+ * jeśli parametr jest niepoprawny lub nie udało się zaalokować pamięci.
+ */
+bool gamma_journal_start(gamma_t *g);
+
+/** @brief Wyłącza dziennik ruchów.
+ * Usuwa historię ruchów i zwalnia zajmowaną przez nią pamięć.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ */
+void gamma_journal_stop(gamma_t *g);
+
+/** @brief Cofa ostatni ruch zapisany w dzienniku.
+ * Przywraca stan gry sprzed ruchu bez przeglądania planszy. Koszt cofnięcia
+ * jest taki sam jak koszt cofanego ruchu.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli ruch został cofnięty, a @p false, jeśli
+ * dziennik jest wyłączony lub nie ma w nim ruchu do cofnięcia.
+ */
+bool gamma_undo(gamma_t *g);
+
+/** @brief Ponawia ostatnio cofnięty ruch.
+ * Ruchy cofnięte funkcją @ref gamma_undo można ponowić, dopóki nie zostanie
+ * wykonany nowy ruch.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli ruch został ponowiony, a @p false,
+ * jeśli nie ma ruchu do ponowienia lub nie udało się zaalokować pamięci.
+ */
+bool gamma_redo(gamma_t *g);
+
 #endif /* GAMMA_H */
@@ -0,0 +1,276 @@
+/* Pomiary wydajności silnika gry gamma.
+ * Uruchomienie: gamma_bench [nazwa|all] [ziarno] [powtórzenia]
+ * Każde obciążenie jest deterministyczne dla danego ziarna. Wypisywany jest
+ * najlepszy z powtórzonych pomiarów: liczba operacji, czas jednej operacji,
+ * liczba operacji na sekundę i przyrost pamięci rezydentnej procesu od
+ * utworzenia gry do końca obciążenia na jedno pole planszy. */
+#define _GNU_SOURCE
+
+#include "gamma.h"
+
+#include <inttypes.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/** KONFIGURACJA POMIARÓW **/
+
+#define DEFAULT_SEED 42
+#define DEFAULT_REPEATS 3
+
+#define SMALL_BOARD_SIZE    100
+#define BIG_BOARD_SIZE     1000
+#define BIG_BOARD_CELLS    ((uint64_t) BIG_BOARD_SIZE * BIG_BOARD_SIZE)
+
+#define SIZE(x) (sizeof(x) / sizeof(x)[0])
+
+/** FUNKCJE POMOCNICZE **/
+
+typedef struct {
+    uint64_t ops;
+    uint64_t nanoseconds;
+    uint64_t cells;
+    uint64_t bytes;
+} result_t;
+
+static uint64_t state;
+
+static uint64_t next_random(void) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static uint32_t random_below(uint32_t n) {
+    return (uint32_t) ((next_random() >> 32) * n >> 32);
+}
+
+static uint64_t now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000000000 + (uint64_t) t.tv_nsec;
+}
+
+static uint64_t resident_bytes(void) {
+    // Fragmenty planszy są alokowane przy pierwszym zapisie, a fragmenty
+    // dużych plansz leżą w odwzorowaniu, którego nie widzi mallinfo2,
+    // więc pamięć gry mierzona jest rozmiarem pamięci rezydentnej.
+    unsigned long pages = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm != NULL) {
+        if (fscanf(statm, "%*s %lu", &pages) != 1) {
+            pages = 0;
+        }
+        fclose(statm);
+    }
+    return (uint64_t) pages * (uint64_t) sysconf(_SC_PAGESIZE);
+}
+
+static gamma_t *new_game(result_t *r, uint32_t width, uint32_t height,
+                         uint32_t players, uint32_t areas) {
+    r->bytes = resident_bytes();
+    gamma_t *g = gamma_new(width, height, players, areas);
+    if (g == NULL) {
+        fprintf(stderr, "gamma_new(%" PRIu32 ", %" PRIu32 ", %" PRIu32
+                ", %" PRIu32 ") failed\n", width, height, players, areas);
+        exit(EXIT_FAILURE);
+    }
+    r->cells = (uint64_t) width * height;
+    return g;
+}
+
+static void delete_game(result_t *r, gamma_t *g) {
+    uint64_t after = resident_bytes();
+    r->bytes = after > r->bytes ? after - r->bytes : 0;
+    gamma_delete(g);
+    // Zwolniona pamięć wraca do systemu, aby nie zaniżać kolejnych pomiarów.
+    malloc_trim(0);
+}
+
+static void random_moves(gamma_t *g, uint32_t width, uint32_t height,
+                         uint32_t players, uint64_t count) {
+    for (uint64_t i = 0; i < count; i++) {
+        gamma_move(g, 1 + random_below(players), random_below(width),
+                   random_below(height));
+    }
+}
+
+/** OBCIĄŻENIA **/
+
+static void random_fill(result_t *r) {
+    gamma_t *g = new_game(r, BIG_BOARD_SIZE, BIG_BOARD_SIZE, 4, 1000);
+    r->ops = 2 * BIG_BOARD_CELLS;
+    uint64_t start = now();
+    random_moves(g, BIG_BOARD_SIZE, BIG_BOARD_SIZE, 4, r->ops);
+    r->nanoseconds = now() - start;
+    delete_game(r, g);
+}
+
+static void area_merge(result_t *r) {
+    // Najpierw powstają osobne obszary na polach o parzystych
+    // współrzędnych, a potem są łączone w losowej kolejności.
+    gamma_t *g = new_game(r, BIG_BOARD_SIZE, BIG_BOARD_SIZE, 2, UINT32_MAX);
+    uint32_t half = BIG_BOARD_SIZE / 2;
+    for (uint32_t y = 0; y < BIG_BOARD_SIZE; y += 2) {
+        for (uint32_t x = 0; x < BIG_BOARD_SIZE; x += 2) {
+            gamma_move(g, 1 + (x / 2 + y / 2) % 2, x, y);
+        }
+    }
+    r->ops = 3 * (uint64_t) half * half;
+    uint64_t start = now();
+    for (uint64_t i = 0; i < r->ops; i++) {
+        uint32_t x = random_below(BIG_BOARD_SIZE);
+        uint32_t y = random_below(BIG_BOARD_SIZE);
+        gamma_move(g, 1 + random_below(2), x, y);
+    }
+    r->nanoseconds = now() - start;
+    delete_game(r, g);
+}
+
+static void golden_moves(result_t *r) {
+    // Udany złoty ruch jest cofany, aby każdy gracz mógł go powtarzać.
+    gamma_t *g = new_game(r, SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 8, 20);
+    random_moves(g, SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 8,
+                 10 * SMALL_BOARD_SIZE * SMALL_BOARD_SIZE);
+    if (!gamma_journal_start(g)) {
+        exit(EXIT_FAILURE);
+    }
+    r->ops = 200000;
+    uint64_t start = now();
+    for (uint64_t i = 0; i < r->ops; i++) {
+        if (gamma_golden_move(g, 1 + random_below(8),
+                              random_below(SMALL_BOARD_SIZE),
+                              random_below(SMALL_BOARD_SIZE))) {
+            gamma_undo(g);
+        }
+    }
+    r->nanoseconds = now() - start;
+    delete_game(r, g);
+}
+
+static void golden_polling(result_t *r) {
+    // Po każdym ruchu sprawdzana jest możliwość złotego ruchu wszystkich
+    // graczy, tak jak robią to polecenia q w trybie wsadowym.
+    uint32_t players = 8;
+    gamma_t *g = new_game(r, BIG_BOARD_SIZE, BIG_BOARD_SIZE, players, 4);
+    random_moves(g, BIG_BOARD_SIZE, BIG_BOARD_SIZE, players, BIG_BOARD_CELLS);
+    uint64_t moves = 20000;
+    r->ops = moves * players;
+    uint64_t start = now();
+    for (uint64_t i = 0; i < moves; i++) {
+        gamma_move(g, 1 + random_below(players), random_below(BIG_BOARD_SIZE),
+                   random_below(BIG_BOARD_SIZE));
+        for (uint32_t p = 1; p <= players; p++) {
+            gamma_golden_possible(g, p);
+        }
+    }
+    r->nanoseconds = now() - start;
+    delete_game(r, g);
+}
+
+static void board_render(result_t *r) {
+    gamma_t *g = new_game(r, BIG_BOARD_SIZE, BIG_BOARD_SIZE, 12, 1000);
+    random_moves(g, BIG_BOARD_SIZE, BIG_BOARD_SIZE, 12, BIG_BOARD_CELLS);
+    uint64_t size = gamma_board_size(g);
+    char *board = malloc(size);
+    if (board == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    r->ops = 20;
+    uint64_t start = now();
+    for (uint64_t i = 0; i < r->ops; i++) {
+        gamma_board_into(g, board, size);
+    }
+    r->nanoseconds = now() - start;
+    free(board);
+    delete_game(r, g);
+}
+
+static void big_board(result_t *r) {
+    // Rozmiary z testu big_board, na których da się wykonać ruchy.
+    static const uint32_t sizes[][2] = {
+            {(1 << 11) + 1, (1 << 10) + 1},
+            {(1 << 12) + 1, (1 << 11) + 1},
+            {(1 << 13) + 1, (1 << 12) + 1},
+    };
+    uint64_t moves = 1000000;
+    r->ops = 0;
+    r->nanoseconds = 0;
+    r->cells = 0;
+    r->bytes = 0;
+    for (size_t i = 0; i < SIZE(sizes); i++) {
+        result_t game;
+        gamma_t *g = new_game(&game, sizes[i][0], sizes[i][1], 2, 5);
+        uint64_t start = now();
+        random_moves(g, sizes[i][0], sizes[i][1], 2, moves);
+        r->nanoseconds += now() - start;
+        delete_game(&game, g);
+        r->ops += moves;
+        r->cells += game.cells;
+        r->bytes += game.bytes;
+    }
+}
+
+/** URUCHAMIANIE POMIARÓW **/
+
+typedef struct {
+    char const *name;
+
+    void (*function)(result_t *);
+} bench_list_t;
+
+#define BENCH(b) {#b, b}
+
+static const bench_list_t bench_list[] = {
+        BENCH(random_fill),
+        BENCH(area_merge),
+        BENCH(golden_moves),
+        BENCH(golden_polling),
+        BENCH(board_render),
+        BENCH(big_board),
+};
+
+static void run(const bench_list_t *bench, uint64_t seed, unsigned repeats) {
+    result_t best = {0, UINT64_MAX, 0, 0};
+    for (unsigned i = 0; i < repeats; i++) {
+        result_t r;
+        state = seed * 0x9E3779B97F4A7C15u + 1;
+        bench->function(&r);
+        if (r.nanoseconds < best.nanoseconds) {
+            best = r;
+        }
+    }
+    double ns_per_op = (double) best.nanoseconds / (double) best.ops;
+    printf("%-16s %12" PRIu64 " %12.1f %14.0f %12.2f\n", bench->name,
+           best.ops, ns_per_op, 1e9 / ns_per_op,
+           (double) best.bytes / (double) best.cells);
+}
+
+int main(int argc, char *argv[]) {
+    const char *name = argc > 1 ? argv[1] : "all";
+    uint64_t seed = argc > 2 ? strtoull(argv[2], NULL, 10) : DEFAULT_SEED;
+    unsigned repeats = argc > 3 ? (unsigned) strtoul(argv[3], NULL, 10) :
+                       DEFAULT_REPEATS;
+    if (repeats == 0) {
+        repeats = 1;
+    }
+
+    printf("%-16s %12s %12s %14s %12s\n", "workload", "ops", "ns/op",
+           "ops/s", "bytes/cell");
+    bool found = false;
+    for (size_t i = 0; i < SIZE(bench_list); i++) {
+        if (strcmp(name, "all") == 0 || strcmp(name, bench_list[i].name) == 0) {
+            run(bench_list + i, seed, repeats);
+            found = true;
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "unknown workload: %s\n", name);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
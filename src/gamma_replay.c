@@ -0,0 +1,211 @@
+/* Pomiar przepustowości programu gamma na skryptach trybu wsadowego.
+ * Uruchomienie: gamma_replay [-b program] [-r powtórzenia] [-f] [-o plik]
+ *                            skrypt...
+ * Każdy skrypt podawany jest programowi (domyślnie ./gamma) przez potok,
+ * tak jak w środowisku produkcyjnym, albo z opcją -f bezpośrednio jako plik.
+ * Wyjście programu trafia do /dev/null lub do podanego pliku. Dla każdego
+ * skryptu wypisywany jest najlepszy z powtórzonych pomiarów: liczba wierszy,
+ * czas, liczba wierszy na sekundę, przepustowość w MB/s i maksymalny rozmiar
+ * pamięci rezydentnej programu. */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define DEFAULT_BINARY "./gamma"
+#define DEFAULT_REPEATS 3
+
+typedef struct {
+    const char *binary;
+    const char *output;
+    unsigned repeats;
+    bool direct;
+} options_t;
+
+typedef struct {
+    uint64_t nanoseconds;
+    long max_rss;
+    int status;
+} result_t;
+
+static uint64_t now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000000000 + (uint64_t) t.tv_nsec;
+}
+
+static bool write_all(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        length -= (size_t) n;
+    }
+    return true;
+}
+
+static uint64_t count_lines(const char *data, size_t size) {
+    uint64_t lines = 0;
+    const char *end = data + size;
+    for (const char *c = data; (c = memchr(c, '\n', (size_t) (end - c)));
+         c++) {
+        lines++;
+    }
+    if (size > 0 && data[size - 1] != '\n') {
+        lines++;
+    }
+    return lines;
+}
+
+static void close_all(int *fds, int count) {
+    for (int i = 0; i < count; i++) {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+        }
+    }
+}
+
+static bool run_once(const options_t *o, const char *path, const char *data,
+                     size_t size, result_t *r) {
+    // Wejście programu w trybie -f, końce potoku i wyjście programu.
+    int fds[4] = {-1, -1, -1, -1};
+    int *input = fds, *channel = fds + 1, *output = fds + 3;
+    if (o->direct) {
+        *input = open(path, O_RDONLY);
+    }
+    if ((o->direct && *input < 0) || (!o->direct && pipe(channel) != 0)) {
+        return false;
+    }
+    *output = open(o->output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (*output < 0) {
+        close_all(fds, 4);
+        return false;
+    }
+
+    uint64_t start = now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(o->direct ? *input : channel[0], STDIN_FILENO);
+        dup2(*output, STDOUT_FILENO);
+        dup2(*output, STDERR_FILENO);
+        close_all(fds, 4);
+        execl(o->binary, o->binary, (char *) NULL);
+        _exit(127);
+    }
+    if (pid < 0) {
+        close_all(fds, 4);
+        return false;
+    }
+    close(o->direct ? *input : channel[0]);
+    close(*output);
+    if (!o->direct) {
+        write_all(channel[1], data, size);
+        close(channel[1]);
+    }
+
+    struct rusage usage;
+    if (wait4(pid, &r->status, 0, &usage) != pid) {
+        return false;
+    }
+    r->nanoseconds = now() - start;
+    r->max_rss = usage.ru_maxrss;
+    return true;
+}
+
+static bool replay(const options_t *o, const char *path) {
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    size_t size = (size_t) info.st_size;
+    char *data = size == 0 ? NULL :
+                 mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "cannot map %s\n", path);
+        return false;
+    }
+
+    result_t best = {UINT64_MAX, 0, 0};
+    bool ok = true;
+    for (unsigned i = 0; ok && i < o->repeats; i++) {
+        result_t r;
+        ok = run_once(o, path, data, size, &r);
+        if (ok && r.nanoseconds < best.nanoseconds) {
+            best = r;
+        }
+    }
+    uint64_t lines = count_lines(data, size);
+    if (data != NULL) {
+        munmap(data, size);
+    }
+    if (!ok) {
+        fprintf(stderr, "cannot run %s\n", o->binary);
+        return false;
+    }
+
+    double seconds = (double) best.nanoseconds / 1e9;
+    printf("%-24s %12" PRIu64 " %10.3f %14.0f %10.1f %12ld %6d\n", path,
+           lines, seconds, (double) lines / seconds,
+           (double) size / 1e6 / seconds, best.max_rss,
+           WIFEXITED(best.status) ? WEXITSTATUS(best.status) :
+           -WTERMSIG(best.status));
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    options_t o = {DEFAULT_BINARY, "/dev/null", DEFAULT_REPEATS, false};
+    int option;
+    while ((option = getopt(argc, argv, "b:r:fo:")) != -1) {
+        switch (option) {
+            case 'b':
+                o.binary = optarg;
+                break;
+            case 'r':
+                o.repeats = (unsigned) strtoul(optarg, NULL, 10);
+                break;
+            case 'f':
+                o.direct = true;
+                break;
+            case 'o':
+                o.output = optarg;
+                break;
+            default:
+                optind = argc + 1;
+        }
+    }
+    if (optind >= argc || o.repeats == 0) {
+        fprintf(stderr, "usage: %s [-b binary] [-r repeats] [-f] [-o output] "
+                        "script...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("%-24s %12s %10s %14s %10s %12s %6s\n", "script", "lines",
+           "seconds", "lines/s", "MB/s", "max RSS kB", "exit");
+    bool ok = true;
+    for (int i = optind; i < argc; i++) {
+        ok = replay(&o, argv[i]) && ok;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
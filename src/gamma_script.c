@@ -0,0 +1,245 @@
+/* Generator skryptów trybu wsadowego gry gamma.
+ * Uruchomienie: gamma_script [-s ziarno] [-w szerokość] [-h wysokość]
+ *                            [-p gracze] [-a obszary] [-n wiersze]
+ *                            [-m mieszanka] [-t topologia]
+ * Wypisuje na standardowe wyjście wiersz B z parametrami gry (z numerem
+ * topologii planszy, jeśli podano inną niż zwykła siatka), a po nim
+ * podaną liczbę poleceń losowanych zgodnie z mieszanką. Mieszanka to lista
+ * wag postaci "m=60,g=5,b=10" dla poleceń m, g, b, f, q, p, Q, S i C oraz
+ * wierszy x (błędnych) i c (komentarzy). Dla tego samego ziarna i tych
+ * samych parametrów powstaje zawsze ten sam skrypt. */
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEFAULT_MIX "m=60,g=5,b=8,f=8,q=15,p=0,Q=0,S=0,C=0,x=2,c=2"
+#define KINDS "mgbfqpQSCxc"
+#define KINDS_NUMBER 11
+#define MALFORMED_NUMBER 8
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+typedef struct {
+    uint64_t seed;
+    uint32_t width;
+    uint32_t height;
+    uint32_t players;
+    uint32_t areas;
+    uint32_t topology;
+    uint64_t lines;
+    uint32_t weights[KINDS_NUMBER];
+} options_t;
+
+static uint64_t state;
+
+static uint64_t next_random(void) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static uint32_t random_below(uint32_t n) {
+    return (uint32_t) ((next_random() >> 32) * n >> 32);
+}
+
+static bool parse_number(const char *text, uint64_t max, uint64_t *result) {
+    char *end;
+    unsigned long long number = strtoull(text, &end, 10);
+    if (*text < '0' || *text > '9' || *end != '\0' || number > max) {
+        return false;
+    }
+    *result = number;
+    return true;
+}
+
+static bool parse_uint32(const char *text, uint32_t *result) {
+    uint64_t number;
+    if (!parse_number(text, UINT32_MAX, &number)) {
+        return false;
+    }
+    *result = (uint32_t) number;
+    return true;
+}
+
+static bool parse_mix(const char *text, uint32_t *weights) {
+    memset(weights, 0, KINDS_NUMBER * sizeof(uint32_t));
+    char *copy = strdup(text);
+    if (copy == NULL) {
+        return false;
+    }
+    bool ok = true;
+    char *save;
+    for (char *item = strtok_r(copy, ",", &save); ok && item != NULL;
+         item = strtok_r(NULL, ",", &save)) {
+        const char *kind = item[0] != '\0' && item[1] == '=' ?
+                           strchr(KINDS, item[0]) : NULL;
+        ok = kind != NULL &&
+             parse_uint32(item + 2, weights + (kind - KINDS));
+    }
+    free(copy);
+    return ok;
+}
+
+static bool parse_options(int argc, char *argv[], options_t *o) {
+    o->seed = 42;
+    o->width = 100;
+    o->height = 100;
+    o->players = 4;
+    o->areas = 10;
+    o->topology = 0;
+    o->lines = 100000;
+    parse_mix(DEFAULT_MIX, o->weights);
+
+    int option;
+    while ((option = getopt(argc, argv, "s:w:h:p:a:n:m:t:")) != -1) {
+        bool ok;
+        switch (option) {
+            case 's':
+                ok = parse_number(optarg, UINT64_MAX, &o->seed);
+                break;
+            case 'w':
+                ok = parse_uint32(optarg, &o->width);
+                break;
+            case 'h':
+                ok = parse_uint32(optarg, &o->height);
+                break;
+            case 'p':
+                ok = parse_uint32(optarg, &o->players);
+                break;
+            case 'a':
+                ok = parse_uint32(optarg, &o->areas);
+                break;
+            case 'n':
+                ok = parse_number(optarg, UINT64_MAX, &o->lines);
+                break;
+            case 'm':
+                ok = parse_mix(optarg, o->weights);
+                break;
+            case 't':
+                ok = parse_uint32(optarg, &o->topology);
+                break;
+            default:
+                ok = false;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+
+    uint64_t total = 0;
+    for (int i = 0; i < KINDS_NUMBER; i++) {
+        total += o->weights[i];
+    }
+    return optind == argc && o->width > 0 && o->height > 0 &&
+           o->players > 0 && o->areas > 0 && total > 0 && total <= UINT32_MAX;
+}
+
+static char pick_kind(const uint32_t *weights, uint32_t total) {
+    uint32_t r = random_below(total);
+    for (int i = 0; i < KINDS_NUMBER; i++) {
+        if (r < weights[i]) {
+            return KINDS[i];
+        }
+        r -= weights[i];
+    }
+    return KINDS[KINDS_NUMBER - 1];
+}
+
+static void print_malformed(const options_t *o) {
+    uint32_t player = 1 + random_below(o->players);
+    uint32_t x = random_below(o->width);
+    uint32_t y = random_below(o->height);
+    switch (random_below(MALFORMED_NUMBER)) {
+        case 0:
+            printf("m %" PRIu32 " %" PRIu32 "\n", player, x);
+            break;
+        case 1:
+            printf("g %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 "\n",
+                   player, x, y, player);
+            break;
+        case 2:
+            printf("m %" PRIu32 " %" PRIu32 " 4294967296\n", player, x);
+            break;
+        case 3:
+            printf(" b %" PRIu32 "\n", player);
+            break;
+        case 4:
+            printf("m%" PRIu32 " %" PRIu32 " %" PRIu32 "\n", player, x, y);
+            break;
+        case 5:
+            printf("x %" PRIu32 " %" PRIu32 " %" PRIu32 "\n", player, x, y);
+            break;
+        case 6:
+            printf("q -%" PRIu32 "\n", player);
+            break;
+        default:
+            printf("p 0\n");
+    }
+}
+
+static void print_line(const options_t *o, char kind) {
+    uint32_t player = 1 + random_below(o->players);
+    switch (kind) {
+        case 'm':
+        case 'g': {
+            uint32_t x = random_below(o->width);
+            uint32_t y = random_below(o->height);
+            printf("%c %" PRIu32 " %" PRIu32 " %" PRIu32 "\n", kind, player,
+                   x, y);
+            break;
+        }
+        case 'b':
+        case 'f':
+        case 'q':
+            printf("%c %" PRIu32 "\n", kind, player);
+            break;
+        case 'p':
+        case 'Q':
+        case 'S':
+        case 'C':
+            printf("%c\n", kind);
+            break;
+        case 'x':
+            print_malformed(o);
+            break;
+        default:
+            printf("# %" PRIu32 "\n", player);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    options_t o;
+    if (!parse_options(argc, argv, &o)) {
+        fprintf(stderr, "usage: %s [-s seed] [-w width] [-h height] "
+                        "[-p players] [-a areas] [-n lines] [-m mix] "
+                        "[-t topology]\n"
+                        "default mix: %s\n", argv[0], DEFAULT_MIX);
+        return EXIT_FAILURE;
+    }
+
+    static char buffer[OUTPUT_BUFFER_SIZE];
+    setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+    state = o.seed * 0x9E3779B97F4A7C15u + 1;
+
+    uint32_t total = 0;
+    for (int i = 0; i < KINDS_NUMBER; i++) {
+        total += o.weights[i];
+    }
+
+    printf("B %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32, o.width,
+           o.height, o.players, o.areas);
+    if (o.topology != 0) {
+        printf(" %" PRIu32, o.topology);
+    }
+    printf("\n");
+    for (uint64_t i = 0; i < o.lines; i++) {
+        print_line(&o, pick_kind(o.weights, total));
+    }
+    return fflush(stdout) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -2,6 +2,7 @@
  * wszystko, co jest potrzebne. */
 #include "gamma.h"
 #include "gamma.h"
+#include "snapshot.h"
 
 /* CMake w wersji release wyłącza asercje. */
 #ifdef NDEBUG
@@ -760,6 +761,484 @@ static int middle_board(void) {
     return PASS;
 }
 
+/* Testuje zapis stanu gry do pliku i odtworzenie go. */
+static int snapshot(void) {
+    static const char path[] = "gamma_test_snapshot.bin";
+
+    gamma_t *g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 3, 2);
+    assert(g != NULL);
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 1, 1, 0));
+    assert(gamma_move(g, 2, 2, 0));
+    assert(gamma_move(g, 2, 2, 1));
+    assert(gamma_move(g, 3, 5, 5));
+    assert(gamma_golden_move(g, 3, 2, 0));
+
+    assert(gamma_save(g, path));
+    gamma_t *h = gamma_load(path);
+    assert(h != NULL);
+
+    char *board_g = gamma_board(g);
+    char *board_h = gamma_board(h);
+    assert(board_g != NULL && board_h != NULL);
+    assert(strcmp(board_g, board_h) == 0);
+    free(board_g);
+    free(board_h);
+
+    for (uint32_t player = 1; player <= 3; player++) {
+        assert(gamma_busy_fields(g, player) == gamma_busy_fields(h, player));
+        assert(gamma_free_fields(g, player) == gamma_free_fields(h, player));
+        assert(gamma_golden_possible(g, player) ==
+               gamma_golden_possible(h, player));
+    }
+
+    // Odtworzona gra toczy się dalej tak samo jak oryginalna.
+    assert(gamma_move(h, 2, 2, 2) == gamma_move(g, 2, 2, 2));
+    assert(gamma_move(h, 1, 9, 9) == gamma_move(g, 1, 9, 9));
+    assert(gamma_golden_move(h, 1, 2, 1) == gamma_golden_move(g, 1, 2, 1));
+    assert(gamma_busy_fields(h, 1) == gamma_busy_fields(g, 1));
+    assert(gamma_busy_fields(h, 2) == gamma_busy_fields(g, 2));
+
+    // Zmiany w odtworzonej grze nie trafiają do pliku.
+    gamma_t *k = gamma_load(path);
+    assert(k != NULL);
+    assert(gamma_busy_fields(k, 1) == 2);
+    assert(gamma_busy_fields(k, 2) == 1);
+
+    // Liczniki zależne od sąsiedztwa są odtwarzane z planszy, a plik,
+    // w którym gracz ma więcej obszarów niż limit, jest odrzucany.
+    snapshot_header_t header;
+    snapshot_player_t record;
+    FILE *file = fopen(path, "r+b");
+    assert(file != NULL);
+    assert(fread(&header, sizeof(header), 1, file) == 1);
+    long offset = (long) (header.players_offset + 2 * sizeof(record));
+    assert(fseek(file, offset, SEEK_SET) == 0);
+    assert(fread(&record, sizeof(record), 1, file) == 1);
+    record.always_free_fields = 12345;
+    record.border_fields = 0;
+    record.safe_border_fields = 0;
+    assert(fseek(file, offset, SEEK_SET) == 0);
+    assert(fwrite(&record, sizeof(record), 1, file) == 1);
+    assert(fflush(file) == 0);
+    gamma_t *m = gamma_load(path);
+    assert(m != NULL);
+    assert(gamma_free_fields(m, 3) == gamma_free_fields(k, 3));
+    assert(gamma_golden_possible(m, 1) == gamma_golden_possible(k, 1));
+    gamma_delete(m);
+
+    header.max_areas = 1;
+    assert(fseek(file, 0, SEEK_SET) == 0);
+    assert(fwrite(&header, sizeof(header), 1, file) == 1);
+    assert(fclose(file) == 0);
+    assert(gamma_load(path) == NULL);
+
+    gamma_delete(g);
+    gamma_delete(h);
+    gamma_delete(k);
+    remove(path);
+
+    assert(gamma_save(NULL, path) == false);
+    assert(gamma_load(path) == NULL);
+
+    return PASS;
+}
+
+/* Testuje cofanie i ponawianie ruchów. */
+static int undo_redo(void) {
+    gamma_t *g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 2, 1);
+    assert(g != NULL);
+    assert(gamma_move(g, 1, 0, 0));
+    assert(!gamma_undo(g));
+    assert(gamma_journal_start(g));
+
+    char *board_before = gamma_board(g);
+    assert(board_before != NULL);
+
+    assert(gamma_move(g, 1, 1, 0));
+    assert(gamma_move(g, 2, 0, 1));
+    assert(gamma_move(g, 2, 1, 1));
+    assert(gamma_golden_move(g, 2, 0, 0));
+    assert(gamma_busy_fields(g, 1) == 1);
+    assert(gamma_busy_fields(g, 2) == 3);
+    assert(!gamma_golden_possible(g, 2));
+
+    char *board_after = gamma_board(g);
+    assert(board_after != NULL);
+
+    for (int i = 0; i < 4; i++) {
+        assert(gamma_undo(g));
+    }
+    assert(!gamma_undo(g));
+
+    char *board = gamma_board(g);
+    assert(board != NULL);
+    assert(strcmp(board, board_before) == 0);
+    free(board);
+    assert(gamma_busy_fields(g, 1) == 1);
+    assert(gamma_busy_fields(g, 2) == 0);
+    assert(gamma_free_fields(g, 2) == SMALL_BOARD_SIZE * SMALL_BOARD_SIZE - 1);
+
+    for (int i = 0; i < 4; i++) {
+        assert(gamma_redo(g));
+    }
+    assert(!gamma_redo(g));
+
+    board = gamma_board(g);
+    assert(board != NULL);
+    assert(strcmp(board, board_after) == 0);
+    free(board);
+    assert(!gamma_golden_possible(g, 2));
+
+    // Nowy ruch uniemożliwia ponowienie cofniętych ruchów.
+    assert(gamma_undo(g));
+    assert(gamma_golden_possible(g, 2));
+    assert(gamma_move(g, 1, 5, 5) == false);
+    assert(gamma_move(g, 1, 0, 2) == false);
+    assert(gamma_move(g, 2, 2, 1));
+    assert(!gamma_redo(g));
+
+    gamma_journal_stop(g);
+    assert(!gamma_undo(g));
+
+    free(board_before);
+    free(board_after);
+    gamma_delete(g);
+    return PASS;
+}
+
+static int clone(void) {
+    gamma_t *g = gamma_new(MIDDLE_BOARD_SIZE, MIDDLE_BOARD_SIZE, 3, 2);
+    assert(g != NULL);
+    assert(gamma_clone(NULL) == NULL);
+    for (uint32_t x = 0; x < MIDDLE_BOARD_SIZE; x++) {
+        assert(gamma_move(g, 1, x, 0));
+        assert(gamma_move(g, 2, x, MIDDLE_BOARD_SIZE - 1));
+    }
+    assert(gamma_move(g, 3, 50, 50));
+
+    char *board_before = gamma_board(g);
+    assert(board_before != NULL);
+    gamma_t *c = gamma_clone(g);
+    assert(c != NULL);
+
+    // Zmiany w kopii nie mogą być widoczne w oryginale i odwrotnie.
+    assert(gamma_golden_move(c, 3, 50, 0));
+    assert(gamma_busy_fields(c, 1) == MIDDLE_BOARD_SIZE - 1);
+    assert(gamma_busy_fields(c, 3) == 2);
+    assert(gamma_move(c, 1, 50, 1) == false);
+    assert(gamma_move(g, 2, 50, 51));
+    assert(gamma_busy_fields(g, 1) == MIDDLE_BOARD_SIZE);
+    assert(gamma_busy_fields(g, 2) == MIDDLE_BOARD_SIZE + 1);
+    assert(gamma_busy_fields(c, 2) == MIDDLE_BOARD_SIZE);
+    assert(gamma_golden_possible(g, 3));
+    assert(!gamma_golden_possible(c, 3));
+
+    gamma_t *d = gamma_clone(c);
+    assert(d != NULL);
+    gamma_delete(c);
+    assert(gamma_busy_fields(d, 3) == 2);
+    assert(gamma_move(d, 3, 50, 1));
+    assert(gamma_busy_fields(d, 3) == 3);
+    assert(gamma_busy_fields(d, 1) == MIDDLE_BOARD_SIZE - 1);
+
+    assert(gamma_golden_move(g, 2, 50, 50));
+    assert(gamma_golden_move(g, 3, 50, 51));
+    gamma_delete(d);
+
+    gamma_t *e = gamma_clone(g);
+    assert(e != NULL);
+    gamma_delete(g);
+    assert(gamma_busy_fields(e, 2) == MIDDLE_BOARD_SIZE + 1);
+    assert(gamma_busy_fields(e, 3) == 1);
+    assert(gamma_golden_possible(e, 1));
+    assert(gamma_move(e, 3, 50, 52));
+    assert(gamma_move(e, 2, 10, 10) == false);
+
+    char *board = gamma_board(e);
+    assert(board != NULL);
+    assert(strcmp(board, board_before) != 0);
+    free(board);
+
+    free(board_before);
+    gamma_delete(e);
+    return PASS;
+}
+
+static void check_golden_possible_all(gamma_t *g, uint32_t players) {
+    bool result[players];
+    assert(gamma_golden_possible_all(g, result));
+    for (uint32_t i = 1; i <= players; i++) {
+        assert(result[i - 1] == gamma_golden_possible(g, i));
+    }
+}
+
+static int golden_possible_all(void) {
+    bool result[1];
+    assert(!gamma_golden_possible_all(NULL, result));
+
+    // Dla 5 graczy używane są mapy bitowe, a dla 20 zwykłe przejście planszy.
+    uint32_t players[] = {5, 20};
+    for (size_t k = 0; k < SIZE(players); k++) {
+        gamma_t *g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE,
+                               players[k], 3);
+        assert(g != NULL);
+        assert(!gamma_golden_possible_all(g, NULL));
+        check_golden_possible_all(g, players[k]);
+
+        uint32_t seed = 12345;
+        for (uint32_t i = 0; i < 2000; i++) {
+            seed = seed * 1103515245 + 12345;
+            uint32_t player = 1 + (seed >> 16) % players[k];
+            seed = seed * 1103515245 + 12345;
+            uint32_t x = (seed >> 16) % SMALL_BOARD_SIZE;
+            seed = seed * 1103515245 + 12345;
+            uint32_t y = (seed >> 16) % SMALL_BOARD_SIZE;
+            if (i % 50 == 49) {
+                gamma_golden_move(g, player, x, y);
+            } else {
+                gamma_move(g, player, x, y);
+            }
+            if (i % 10 == 0) {
+                check_golden_possible_all(g, players[k]);
+            }
+        }
+        check_golden_possible_all(g, players[k]);
+        gamma_delete(g);
+    }
+    return PASS;
+}
+
+static int stats_all(void) {
+    gamma_stats_t stats[3];
+    assert(!gamma_stats_all(NULL, stats));
+
+    gamma_t *g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 3, 2);
+    assert(g != NULL);
+    assert(!gamma_stats_all(g, NULL));
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 1, 2, 0));
+    assert(gamma_move(g, 1, 1, 0));
+    assert(gamma_move(g, 2, 5, 5));
+    assert(gamma_golden_move(g, 2, 1, 0));
+
+    assert(gamma_stats_all(g, stats));
+    for (uint32_t i = 1; i <= 3; i++) {
+        assert(stats[i - 1].busy_fields == gamma_busy_fields(g, i));
+        assert(stats[i - 1].free_fields == gamma_free_fields(g, i));
+        assert(stats[i - 1].golden_possible == gamma_golden_possible(g, i));
+    }
+    assert(stats[0].busy_fields == 2);
+    assert(stats[0].areas == 2);
+    assert(stats[1].busy_fields == 2);
+    assert(stats[1].areas == 2);
+    assert(!stats[1].golden_possible);
+    assert(stats[2].busy_fields == 0);
+    assert(stats[2].areas == 0);
+    assert(stats[2].free_fields == SMALL_BOARD_SIZE * SMALL_BOARD_SIZE - 4);
+    assert(stats[2].golden_possible);
+
+    gamma_delete(g);
+    return PASS;
+}
+
+static int board_window(void) {
+    gamma_t *g = gamma_new(5, 4, 12, 20);
+    assert(g != NULL);
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 11, 2, 1));
+    assert(gamma_move(g, 3, 4, 3));
+    assert(gamma_move(g, 12, 3, 2));
+
+    char buffer[64];
+    assert(gamma_board_window_size(NULL, 2, 2) == 0);
+    assert(gamma_board_window_size(g, 3, 2) == 15);
+    assert(gamma_board_window_into(g, 2, 1, 3, 2, buffer, 15));
+    assert(strcmp(buffer, "_.12_.\n11_._.\n") == 0);
+    assert(gamma_board_window_into(g, 0, 0, 1, 1, buffer, 4));
+    assert(strcmp(buffer, "_1\n") == 0);
+    assert(!gamma_board_window_into(g, 2, 1, 3, 2, buffer, 14));
+    assert(!gamma_board_window_into(g, 3, 0, 3, 1, buffer, sizeof(buffer)));
+    assert(!gamma_board_window_into(g, 0, 1, 1, 4, buffer, sizeof(buffer)));
+    assert(!gamma_board_window_into(NULL, 0, 0, 1, 1, buffer, sizeof(buffer)));
+    assert(!gamma_board_window_into(g, 0, 0, 1, 1, NULL, sizeof(buffer)));
+
+    char *board = gamma_board(g);
+    assert(board != NULL);
+    assert(gamma_board_window_into(g, 0, 0, 5, 4, buffer, sizeof(buffer)));
+    assert(strcmp(buffer, board) == 0);
+    free(board);
+
+    gamma_delete(g);
+    return PASS;
+}
+
+static int counters(void) {
+    gamma_counters_t c;
+    assert(!gamma_counters(NULL, &c));
+
+    gamma_t *g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 2, 2);
+    assert(g != NULL);
+    assert(!gamma_counters(g, NULL));
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_counters(g, &c));
+    assert(c.root_finds == 0 && c.merges == 0 && c.neighbour_counts == 0);
+
+    gamma_counters_enable(g, true);
+    assert(gamma_move(g, 1, 2, 0));
+    assert(gamma_move(g, 1, 1, 0));
+    assert(gamma_move(g, 2, 5, 5));
+    assert(gamma_golden_move(g, 2, 1, 0));
+    assert(gamma_counters(g, &c));
+    assert(c.merges == 2);
+    assert(c.root_finds >= 4);
+    assert(c.root_steps >= 1);
+    assert(c.rebuild_visits == 2);
+    assert(c.golden_probes == 1);
+    assert(c.split_searches == 1);
+    assert(c.split_visits >= 2);
+    assert(c.neighbour_counts > 0);
+
+    gamma_counters_enable(g, false);
+    assert(gamma_move(g, 1, 0, 1));
+    gamma_counters_t after;
+    assert(gamma_counters(g, &after));
+    assert(memcmp(&c, &after, sizeof(gamma_counters_t)) == 0);
+
+    gamma_counters_enable(g, true);
+    assert(gamma_counters(g, &c));
+    assert(c.root_finds == 0 && c.merges == 0 && c.split_visits == 0);
+
+    gamma_delete(g);
+    return PASS;
+}
+
+/* Testuje planszę w pliku, której pola mają indeksy większe niż UINT32_MAX. */
+static int file_board(void) {
+    static const char path[] = "gamma_test_board.bin";
+    uint32_t width = 1 << 17, height = (1 << 15) + 1;
+    uint64_t size = (uint64_t) width * height;
+
+    assert(gamma_new(width, height, 2, 5) == NULL);
+    remove(path);
+    assert(gamma_new_file(path, 1 << 20, (1 << 20) + 1, 2, 5) == NULL);
+    assert(fopen(path, "r") == NULL);
+    gamma_t *g = gamma_new_file(path, width, height, 2, 5);
+    assert(g != NULL);
+    assert(fopen(path, "r") == NULL);
+    assert(gamma_free_fields(g, 1) == size);
+
+    assert(gamma_move(g, 2, 0, 0));
+    assert(gamma_move(g, 1, width - 1, height - 1));
+    assert(gamma_move(g, 1, width - 2, height - 1));
+    assert(gamma_move(g, 2, width - 1, height - 2));
+    assert(gamma_golden_move(g, 2, width - 1, height - 1));
+    assert(gamma_busy_fields(g, 1) == 1);
+    assert(gamma_busy_fields(g, 2) == 3);
+    assert(gamma_free_fields(g, 1) == size - 4);
+
+    // Złoty ruch rozdzielający obszar przeszukuje planszę bez tablicy
+    // etykiet wszystkich pól.
+    assert(gamma_move(g, 2, 10, 5));
+    assert(gamma_move(g, 2, 11, 5));
+    assert(gamma_move(g, 2, 12, 5));
+    assert(gamma_golden_move(g, 1, 11, 5));
+    assert(gamma_busy_fields(g, 1) == 2);
+    assert(gamma_busy_fields(g, 2) == 5);
+    assert(gamma_move(g, 2, 11, 4));
+    assert(!gamma_move(g, 2, 20, 5));
+
+    char buffer[7];
+    assert(gamma_board_window_into(g, width - 2, height - 2, 2, 2, buffer,
+                                   sizeof(buffer)));
+    assert(strcmp(buffer, "12\n.2\n") == 0);
+    assert(gamma_board_window_into(g, 0, 0, 2, 2, buffer, sizeof(buffer)));
+    assert(strcmp(buffer, "..\n2.\n") == 0);
+
+    gamma_delete(g);
+    return PASS;
+}
+
+static int topologies(void) {
+    assert(gamma_new_topology(3, 3, 2, 1, GAMMA_TOPOLOGIES) == NULL);
+
+    // Przeciwległe brzegi torusa sąsiadują ze sobą.
+    gamma_t *g = gamma_new_topology(4, 4, 2, 1, GAMMA_TORUS);
+    assert(g != NULL);
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 1, 3, 0));
+    assert(gamma_move(g, 1, 0, 3));
+    assert(!gamma_move(g, 1, 2, 2));
+    assert(gamma_free_fields(g, 1) == 7);
+    assert(gamma_move(g, 2, 1, 0));
+    assert(!gamma_golden_move(g, 2, 0, 0));
+    assert(gamma_move(g, 1, 3, 3));
+    gamma_t *c = gamma_clone(g);
+    assert(c != NULL);
+    assert(gamma_golden_move(c, 2, 0, 0));
+    gamma_delete(c);
+    gamma_delete(g);
+
+    // W nieparzystych wierszach sąsiedzi z sąsiednich wierszy leżą w tej
+    // samej i następnej kolumnie.
+    g = gamma_new_topology(3, 3, 2, 1, GAMMA_HEX);
+    assert(g != NULL);
+    assert(gamma_move(g, 1, 1, 0));
+    assert(gamma_move(g, 1, 0, 1));
+    assert(!gamma_move(g, 1, 2, 2));
+    assert(gamma_free_fields(g, 1) == 5);
+    gamma_delete(g);
+
+    g = gamma_new_topology(3, 3, 2, 1, GAMMA_KING);
+    assert(g != NULL);
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 1, 1, 1));
+    assert(gamma_move(g, 1, 2, 2));
+    assert(gamma_free_fields(g, 1) == 6);
+    assert(gamma_move(g, 2, 1, 0));
+    assert(!gamma_golden_move(g, 2, 1, 1));
+    assert(gamma_golden_possible(g, 2));
+    assert(gamma_golden_move(g, 2, 0, 0));
+    assert(gamma_busy_fields(g, 2) == 2);
+    gamma_delete(g);
+    return PASS;
+}
+
+static uint32_t next_draw(uint32_t *seed, uint32_t n) {
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed >> 16) % n;
+}
+
+/* Testuje sprawdzanie złotego ruchu z buforami spoza gry. */
+static int golden_possible_with(void) {
+    gamma_scratch_t *s = gamma_scratch_new();
+    assert(s != NULL);
+    assert(!gamma_golden_possible_with(NULL, 1, s));
+
+    // Te same bufory służą kolejno grom o różnych rozmiarach planszy.
+    static const uint32_t sizes[] = {5, 40, 7};
+    uint32_t seed = 1;
+    for (size_t i = 0; i < SIZE(sizes); i++) {
+        gamma_t *g = gamma_new(sizes[i], sizes[i], 4, 2);
+        assert(g != NULL);
+        assert(!gamma_golden_possible_with(g, 1, NULL));
+        for (int move = 0; move < 400; move++) {
+            uint32_t player = 1 + next_draw(&seed, 4);
+            uint32_t x = next_draw(&seed, sizes[i]);
+            gamma_move(g, player, x, next_draw(&seed, sizes[i]));
+            for (uint32_t p = 1; p <= 4; p++) {
+                assert(gamma_golden_possible_with(g, p, s) ==
+                       gamma_golden_possible(g, p));
+            }
+        }
+        gamma_delete(g);
+    }
+
+    gamma_scratch_delete(s);
+    gamma_scratch_delete(NULL);
+    return PASS;
+}
+
 /** URUCHAMIANIE TESTÓW **/
 
 typedef struct {
@@ -786,6 +1265,16 @@ static const test_list_t test_list[] = {
         TEST(memory_alloc),
         TEST(big_board),
         TEST(middle_board),
+        TEST(snapshot),
+        TEST(undo_redo),
+        TEST(clone),
+        TEST(golden_possible_all),
+        TEST(stats_all),
+        TEST(board_window),
+        TEST(counters),
+        TEST(file_board),
+        TEST(topologies),
+        TEST(golden_possible_with),
 };
 
 int main(int argc, char *argv[]) {
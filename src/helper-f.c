@@ -1,104 +1,390 @@
 #include "helper-f.h"
+#include "journal.h"
+#include <string.h>
 
 typedef enum {
     DIR_START = 0, LEFT = 0, TOP, RIGHT, BOTTOM, DIR_END
 } dir_t;
 
+typedef struct topology {
+    uint8_t degree;
+    bool wraps;
+    int8_t dx[2][NEIGHBOURS];
+    int8_t dy[2][NEIGHBOURS];
+} topology_t;
+
+// Przesunięcia sąsiadów pól w wierszach parzystych i nieparzystych.
+static const topology_t topologies[GAMMA_TOPOLOGIES] = {
+        [GAMMA_SQUARE] = {4, false,
+                          {{-1, 0, 1, 0}, {-1, 0, 1, 0}},
+                          {{0, -1, 0, 1}, {0, -1, 0, 1}}},
+        [GAMMA_TORUS] = {4, true,
+                         {{-1, 0, 1, 0}, {-1, 0, 1, 0}},
+                         {{0, -1, 0, 1}, {0, -1, 0, 1}}},
+        [GAMMA_HEX] = {6, false,
+                       {{-1, -1, 0, 1, 0, -1}, {-1, 0, 1, 1, 1, 0}},
+                       {{0, -1, -1, 0, 1, 1}, {0, -1, -1, 0, 1, 1}}},
+        [GAMMA_KING] = {8, false,
+                        {{-1, -1, 0, 1, 1, 1, 0, -1},
+                         {-1, -1, 0, 1, 1, 1, 0, -1}},
+                        {{0, -1, -1, -1, 0, 1, 1, 1},
+                         {0, -1, -1, -1, 0, 1, 1, 1}}},
+};
+
 player_t *get_player(gamma_t *g, uint32_t p) {
     return (g->players) + p - 1;
 }
 
-field_t *get_field(gamma_t *g, uint32_t x, uint32_t y) {
-    return (g->board) + (g->board_width) * y + x;
+player_t *edit_player(gamma_t *g, uint32_t p) {
+    if (g->journal.enabled) {
+        journal_player(g, p);
+    }
+    return get_player(g, p);
 }
 
-static bool get_position(gamma_t *g, uint32_t x_field, uint32_t y_field, dir_t dir, uint32_t *x, uint32_t *y) {
-    if (dir == LEFT && x_field > 0) {
-        *x = x_field - 1;
-        *y = y_field;
-        return true;
+uint64_t get_index(gamma_t *g, uint32_t x, uint32_t y) {
+    return (uint64_t) g->board_width * y + x;
+}
+
+void get_coordinates(gamma_t *g, uint64_t index, uint32_t *x, uint32_t *y) {
+    *x = (uint32_t) (index % g->board_width);
+    *y = (uint32_t) (index / g->board_width);
+}
+
+chunk_slot_t *get_chunk(gamma_t *g, uint64_t index) {
+    return g->chunks.table[index >> (CHUNK_BITS + SLOT_PAGE_BITS)] +
+           ((index >> CHUNK_BITS) & SLOT_PAGE_MASK);
+}
+
+static uint32_t owner_at(gamma_t *g, uint64_t i) {
+    return get_chunk(g, i)->owners[i & CHUNK_MASK];
+}
+
+static uint64_t parent_at(gamma_t *g, uint64_t i) {
+    return get_chunk(g, i)->parents[i & CHUNK_MASK];
+}
+
+static uint8_t rank_at(gamma_t *g, uint64_t i) {
+    return get_chunk(g, i)->ranks[i & CHUNK_MASK];
+}
+
+uint32_t get_owner(gamma_t *g, uint32_t x, uint32_t y) {
+    return owner_at(g, get_index(g, x, y));
+}
+
+void set_owner(gamma_t *g, uint32_t x, uint32_t y, uint32_t player) {
+    uint64_t i = get_index(g, x, y);
+    uint32_t *owner = get_chunk(g, i)->owners + (i & CHUNK_MASK);
+    if (g->journal.enabled) {
+        journal_cell(g, JOURNAL_OWNER, i, *owner);
     }
-    if (dir == TOP && y_field > 0) {
-        *x = x_field;
-        *y = y_field - 1;
-        return true;
+    bitplanes_move(&g->planes, x, y, *owner, player);
+    *owner = player;
+}
+
+static void set_parent(gamma_t *g, uint64_t i, uint64_t parent) {
+    uint64_t *field = get_chunk(g, i)->parents + (i & CHUNK_MASK);
+    if (g->journal.enabled) {
+        journal_cell(g, JOURNAL_PARENT, i, *field);
     }
-    if (dir == RIGHT && x_field < g->board_width - 1) {
-        *x = x_field + 1;
-        *y = y_field;
-        return true;
+    *field = parent;
+}
+
+static void set_rank(gamma_t *g, uint64_t i, uint8_t rank) {
+    uint8_t *field = get_chunk(g, i)->ranks + (i & CHUNK_MASK);
+    if (g->journal.enabled) {
+        journal_cell(g, JOURNAL_RANK, i, *field);
     }
-    if (dir == BOTTOM && y_field < g->board_height - 1) {
-        *x = x_field;
-        *y = y_field + 1;
-        return true;
+    *field = rank;
+}
+
+static neighbourhood_t *get_neighbourhood(gamma_t *g, uint32_t x,
+                                          uint32_t y) {
+    return g->neighbours + ((x > 0) | (x + 1 < g->board_width) << 1 |
+                            (y > 0) << 2 | (y + 1 < g->board_height) << 3 |
+                            (y & 1) << 4);
+}
+
+static uint64_t neighbour_at(const neighbourhood_t *n, uint64_t i,
+                             uint8_t dir) {
+    return i + (uint64_t) n->offsets[dir];
+}
+
+static void set_neighbourhood(gamma_t *g, uint32_t x, uint32_t y) {
+    const topology_t *t = topologies + g->topology;
+    neighbourhood_t *n = get_neighbourhood(g, x, y);
+    int64_t i = (int64_t) get_index(g, x, y);
+    n->count = 0;
+    for (uint8_t dir = 0; dir < t->degree; dir++) {
+        int64_t nx = (int64_t) x + t->dx[y & 1][dir];
+        int64_t ny = (int64_t) y + t->dy[y & 1][dir];
+        if (t->wraps) {
+            nx = (nx + g->board_width) % g->board_width;
+            ny = (ny + g->board_height) % g->board_height;
+        } else if (nx < 0 || ny < 0 || nx >= g->board_width ||
+                   ny >= g->board_height) {
+            continue;
+        }
+
+        int64_t offset = (int64_t) get_index(g, (uint32_t) nx,
+                                             (uint32_t) ny) - i;
+        bool repeated = offset == 0;
+        for (uint8_t previous = 0; previous < n->count; previous++) {
+            repeated |= n->offsets[previous] == offset;
+        }
+        if (repeated) {
+            continue;
+        }
+
+        n->offsets[n->count] = offset;
+        n->dx[n->count] = (uint32_t) nx - x;
+        n->dy[n->count] = (uint32_t) ny - y;
+        n->count++;
+    }
+}
+
+void set_neighbours(gamma_t *g) {
+    // Każda klasa pól, która występuje na planszy, zawiera jedno z tych pól.
+    uint32_t xs[] = {0, 1, g->board_width - 1};
+    uint32_t ys[] = {0, 1, 2, g->board_height - 1};
+    memset(g->neighbours, 0, sizeof(g->neighbours));
+    for (uint8_t i = 0; i < sizeof(xs) / sizeof(xs[0]); i++) {
+        for (uint8_t j = 0; j < sizeof(ys) / sizeof(ys[0]); j++) {
+            if (xs[i] < g->board_width && ys[j] < g->board_height) {
+                set_neighbourhood(g, xs[i], ys[j]);
+            }
+        }
     }
-    return false;
 }
 
-static field_t *find_area_root(field_t *a) {
-    if (a->parent == NULL) {
-        return a;
+static const int8_t ring_dx[] = {-1, -1, 0, 1, 1, 1, 0, -1};
+static const int8_t ring_dy[] = {0, -1, -1, -1, 0, 1, 1, 1};
+
+#define RING_SIZE 8
+
+static uint32_t get_ring_owner(gamma_t *g, uint32_t field_x, uint32_t field_y,
+                               uint8_t i) {
+    int64_t x = (int64_t) field_x + ring_dx[i];
+    int64_t y = (int64_t) field_y + ring_dy[i];
+    if (x < 0 || y < 0 || x >= g->board_width || y >= g->board_height) {
+        return 0;
     }
+    return get_owner(g, (uint32_t) x, (uint32_t) y);
+}
 
-    a->parent = find_area_root(a->parent);
-    return a->parent;
+static uint8_t rotate_ring(uint8_t ring, uint8_t shift) {
+    return (uint8_t) (ring << shift | ring >> (RING_SIZE - shift));
 }
 
-static void union_areas(field_t *a, field_t *b) {
-    field_t *a_root = find_area_root(a);
-    field_t *b_root = find_area_root(b);
+static bool ring_connected(uint8_t ring) {
+    // Bity parzyste odpowiadają sąsiadom, a nieparzyste rogom. Sąsiad jest
+    // połączony z poprzednim, jeśli zajęte są poprzedni róg i poprzedni sąsiad.
+    uint8_t neighbours = ring & 0x55;
+    uint8_t joined = rotate_ring(ring, 1) & rotate_ring(ring, 2);
+    uint8_t groups = (uint8_t) (neighbours & ~joined);
+    return (groups & (groups - 1)) == 0;
+}
 
-    if (a_root != b_root) {
-        a->player->busy_areas -= 1;
+static bool locally_connected(gamma_t *g, uint32_t field_x, uint32_t field_y) {
+    uint32_t owner = get_owner(g, field_x, field_y);
+    uint8_t ring = 0;
+    for (uint8_t i = 0; i < RING_SIZE; i++) {
+        ring |= (uint8_t) ((get_ring_owner(g, field_x, field_y, i) == owner) << i);
     }
+    return ring_connected(ring);
+}
 
-    if (a_root->rank > b_root->rank) {
-        b_root->parent = a_root;
-    } else if (a_root->rank < b_root->rank) {
-        a_root->parent = b_root;
-    } else if (a_root != b_root) {
-        b_root->parent = a_root;
-        a_root->rank += 1;
+#define WINDOW_SIZE 5
+
+static void read_window(gamma_t *g, uint32_t field_x, uint32_t field_y,
+                        uint32_t window[WINDOW_SIZE][WINDOW_SIZE]) {
+    uint32_t half = WINDOW_SIZE / 2;
+    if (field_x >= half && field_y >= half &&
+        (uint64_t) field_x + half < g->board_width &&
+        (uint64_t) field_y + half < g->board_height) {
+        uint64_t i = get_index(g, field_x - half, field_y - half);
+        for (uint8_t dy = 0; dy < WINDOW_SIZE; dy++, i += g->board_width) {
+            if ((i & CHUNK_MASK) + WINDOW_SIZE <= CHUNK_FIELDS) {
+                const uint32_t *row = get_chunk(g, i)->owners + (i & CHUNK_MASK);
+                for (uint8_t dx = 0; dx < WINDOW_SIZE; dx++) {
+                    window[dy][dx] = row[dx];
+                }
+            } else {
+                for (uint8_t dx = 0; dx < WINDOW_SIZE; dx++) {
+                    window[dy][dx] = owner_at(g, i + dx);
+                }
+            }
+        }
+        return;
+    }
+
+    for (int8_t dy = 0; dy < WINDOW_SIZE; dy++) {
+        int64_t y = (int64_t) field_y + dy - WINDOW_SIZE / 2;
+        for (int8_t dx = 0; dx < WINDOW_SIZE; dx++) {
+            int64_t x = (int64_t) field_x + dx - WINDOW_SIZE / 2;
+            if (x < 0 || y < 0 || x >= g->board_width || y >= g->board_height) {
+                window[dy][dx] = 0;
+            } else {
+                window[dy][dx] = get_owner(g, (uint32_t) x, (uint32_t) y);
+            }
+        }
     }
 }
 
-void merge_with_areas(gamma_t *g, uint32_t field_x, uint32_t field_y) {
-    field_t *f = get_field(g, field_x, field_y);
-    f->parent = NULL;
-    f->rank = 0;
-    uint32_t x, y;
+static bool window_connected(uint32_t window[WINDOW_SIZE][WINDOW_SIZE],
+                             uint8_t x, uint8_t y) {
+    uint8_t ring = 0;
+    for (uint8_t i = 0; i < RING_SIZE; i++) {
+        ring |= (uint8_t) ((window[y + ring_dy[i]][x + ring_dx[i]] ==
+                            window[y][x]) << i);
+    }
+    return ring_connected(ring);
+}
+
+static void border_contribution(gamma_t *g,
+                                uint32_t window[WINDOW_SIZE][WINDOW_SIZE],
+                                uint8_t x, uint8_t y, int8_t border,
+                                int8_t safe) {
+    uint32_t owner = window[y][x];
+    uint32_t neighbours[DIR_END];
+    for (dir_t dir = DIR_START; dir < DIR_END; dir++) {
+        neighbours[dir] = window[y + ring_dy[2 * dir]][x + ring_dx[2 * dir]];
+    }
+
     for (dir_t dir = DIR_START; dir < DIR_END; dir++) {
-        if (!get_position(g, field_x, field_y, dir, &x, &y)) {
+        uint32_t neighbour = neighbours[dir];
+        bool repeated = false;
+        for (dir_t next = dir + 1; next < DIR_END; next++) {
+            repeated |= neighbours[next] == neighbour;
+        }
+
+        if (neighbour == 0 || neighbour == owner || repeated) {
             continue;
         }
 
-        field_t *field = get_field(g, x, y);
+        player_t *p = edit_player(g, neighbour);
+        p->border_fields += (uint64_t) (int64_t) border;
+        p->safe_border_fields += (uint64_t) (int64_t) safe;
+    }
+}
 
-        if (field->player != f->player) {
-            continue;
+void update_owner(gamma_t *g, uint32_t x, uint32_t y, uint32_t player) {
+    if (g->topology != GAMMA_SQUARE) {
+        set_owner(g, x, y, player);
+        return;
+    }
+
+    uint32_t window[WINDOW_SIZE][WINDOW_SIZE];
+    read_window(g, x, y, window);
+
+    // Pola stykające się z danym polem tylko rogiem zmieniają jedynie to, czy
+    // ich usunięcie może podzielić obszar. Pozostałe pola zmieniają również
+    // zbiór sąsiadujących z nimi graczy.
+    bool safe[WINDOW_SIZE][WINDOW_SIZE];
+    for (uint8_t j = 1; j < WINDOW_SIZE - 1; j++) {
+        for (uint8_t i = 1; i < WINDOW_SIZE - 1; i++) {
+            if (window[j][i] == 0) {
+                continue;
+            }
+            safe[j][i] = window_connected(window, i, j);
+            if (i == WINDOW_SIZE / 2 || j == WINDOW_SIZE / 2) {
+                border_contribution(g, window, i, j, -1, (int8_t) -safe[j][i]);
+            }
+        }
+    }
+
+    window[WINDOW_SIZE / 2][WINDOW_SIZE / 2] = player;
+
+    for (uint8_t j = 1; j < WINDOW_SIZE - 1; j++) {
+        for (uint8_t i = 1; i < WINDOW_SIZE - 1; i++) {
+            if (window[j][i] == 0) {
+                continue;
+            }
+            bool now_safe = window_connected(window, i, j);
+            if (i == WINDOW_SIZE / 2 || j == WINDOW_SIZE / 2) {
+                border_contribution(g, window, i, j, 1, (int8_t) now_safe);
+            } else if (now_safe != safe[j][i]) {
+                border_contribution(g, window, i, j, 0,
+                                    (int8_t) (now_safe - safe[j][i]));
+            }
         }
+    }
+
+    set_owner(g, x, y, player);
+}
 
-        union_areas(field, f);
+static uint64_t peek_area_root(gamma_t *g, uint64_t a) {
+    uint64_t root = a;
+    while (parent_at(g, root) != root) {
+        root = parent_at(g, root);
     }
+    return root;
 }
 
-uint8_t count_same_players(gamma_t *g, uint32_t field_x, uint32_t field_y, player_t *p,
-                           uint8_t start) {
-    uint8_t count = 0;
-    uint32_t x, y;
-    for (dir_t dir = DIR_START; dir < DIR_END; dir++) {
-        if (start > dir) {
-            continue;
+static uint64_t find_area_root(gamma_t *g, uint64_t a) {
+    uint64_t root = peek_area_root(g, a);
+    uint64_t steps = a != root;
+
+    while (parent_at(g, a) != root) {
+        uint64_t next = parent_at(g, a);
+        if (!chunks_shared(&g->chunks, a)) {
+            set_parent(g, a, root);
         }
+        a = next;
+        steps++;
+    }
+    COUNT(g, root_finds, 1);
+    COUNT(g, root_steps, steps);
+    return root;
+}
+
+static void union_areas(gamma_t *g, uint64_t a, uint64_t b) {
+    uint64_t a_root = find_area_root(g, a);
+    uint64_t b_root = find_area_root(g, b);
+
+    if (a_root == b_root) {
+        return;
+    }
+
+    COUNT(g, merges, 1);
+    edit_player(g, owner_at(g, a))->busy_areas -= 1;
 
-        if (!get_position(g, field_x, field_y, dir, &x, &y)) {
+    uint8_t a_rank = rank_at(g, a_root);
+    uint8_t b_rank = rank_at(g, b_root);
+    if (a_rank > b_rank) {
+        set_parent(g, b_root, a_root);
+    } else if (a_rank < b_rank) {
+        set_parent(g, a_root, b_root);
+    } else {
+        set_parent(g, b_root, a_root);
+        set_rank(g, a_root, a_rank + 1);
+    }
+}
+
+void merge_with_areas(gamma_t *g, uint32_t field_x, uint32_t field_y) {
+    uint64_t i = get_index(g, field_x, field_y);
+    uint32_t owner = owner_at(g, i);
+    set_parent(g, i, i);
+    set_rank(g, i, 0);
+    const neighbourhood_t *n = get_neighbourhood(g, field_x, field_y);
+    for (uint8_t dir = 0; dir < n->count; dir++) {
+        uint64_t j = neighbour_at(n, i, dir);
+
+        if (owner_at(g, j) != owner) {
             continue;
         }
 
-        field_t *field = get_field(g, x, y);
+        union_areas(g, j, i);
+    }
+}
 
-        if (field->player != p) {
+static uint8_t count_same_at(gamma_t *g, uint64_t i,
+                             const neighbourhood_t *n, uint8_t start,
+                             uint32_t player) {
+    uint8_t count = 0;
+    COUNT(g, neighbour_counts, 1);
+    for (uint8_t dir = start; dir < n->count; dir++) {
+        if (owner_at(g, neighbour_at(n, i, dir)) != player) {
             continue;
         }
 
@@ -107,112 +393,456 @@ uint8_t count_same_players(gamma_t *g, uint32_t field_x, uint32_t field_y, playe
     return count;
 }
 
+uint8_t count_same_players(gamma_t *g, uint32_t field_x, uint32_t field_y,
+                           uint32_t player, uint8_t start) {
+    const neighbourhood_t *n = get_neighbourhood(g, field_x, field_y);
+    return count_same_at(g, get_index(g, field_x, field_y), n, start, player);
+}
+
 void add_always_free(gamma_t *g, uint32_t field_x, uint32_t field_y) {
-    field_t *f = get_field(g, field_x, field_y);
+    uint64_t i = get_index(g, field_x, field_y);
+    uint32_t owner = owner_at(g, i);
+    const neighbourhood_t *n = get_neighbourhood(g, field_x, field_y);
+    for (uint8_t dir = 0; dir < n->count; dir++) {
+        uint64_t j = neighbour_at(n, i, dir);
+        uint32_t neighbour = owner_at(g, j);
+        const neighbourhood_t *around = get_neighbourhood(
+                g, field_x + n->dx[dir], field_y + n->dy[dir]);
 
-    uint32_t x, y;
-    for (dir_t dir = DIR_START; dir < DIR_END; dir++) {
-        if (!get_position(g, field_x, field_y, dir, &x, &y)) {
-            continue;
+        if (neighbour == 0 &&
+            count_same_at(g, j, around, 0, owner) == 1) {
+            edit_player(g, owner)->always_free_fields += 1;
+        } else if (neighbour != 0 &&
+                   count_same_at(g, i, n, dir + 1, neighbour) == 0) {
+            edit_player(g, neighbour)->always_free_fields -= 1;
         }
 
-        field_t *field = get_field(g, x, y);
+    }
+}
 
-        if (!field->player &&
-            count_same_players(g, x, y, f->player, 0) == 1) {
-            f->player->always_free_fields += 1;
-        } else if (field->player &&
-                   count_same_players(g, field_x, field_y, field->player, dir + 1) == 0) {
-            field->player->always_free_fields -= 1;
+void add_field_counters(gamma_t *g, uint32_t field_x, uint32_t field_y) {
+    uint64_t i = get_index(g, field_x, field_y);
+    uint32_t owner = owner_at(g, i);
+    if (owner == 0) {
+        const neighbourhood_t *n = get_neighbourhood(g, field_x, field_y);
+        for (uint8_t dir = 0; dir < n->count; dir++) {
+            uint32_t neighbour = owner_at(g, neighbour_at(n, i, dir));
+            if (neighbour != 0 &&
+                count_same_at(g, i, n, dir + 1, neighbour) == 0) {
+                edit_player(g, neighbour)->always_free_fields += 1;
+            }
         }
-
+    } else if (g->topology == GAMMA_SQUARE) {
+        uint32_t window[WINDOW_SIZE][WINDOW_SIZE];
+        uint8_t centre = WINDOW_SIZE / 2;
+        read_window(g, field_x, field_y, window);
+        border_contribution(g, window, centre, centre, 1,
+                            (int8_t) window_connected(window, centre, centre));
     }
 }
 
 static void remove_always_free(gamma_t *g, uint32_t field_x, uint32_t field_y,
-                               player_t *p) {
-    uint32_t x, y;
-    for (dir_t dir = DIR_START; dir < DIR_END; dir++) {
-        if (!get_position(g, field_x, field_y, dir, &x, &y)) {
-            continue;
+                               uint32_t player) {
+    uint64_t i = get_index(g, field_x, field_y);
+    const neighbourhood_t *n = get_neighbourhood(g, field_x, field_y);
+    for (uint8_t dir = 0; dir < n->count; dir++) {
+        uint64_t j = neighbour_at(n, i, dir);
+        uint32_t neighbour = owner_at(g, j);
+        const neighbourhood_t *around = get_neighbourhood(
+                g, field_x + n->dx[dir], field_y + n->dy[dir]);
+
+        if (neighbour == 0 &&
+            count_same_at(g, j, around, 0, player) == 0) {
+            edit_player(g, player)->always_free_fields -= 1;
+        } else if (neighbour != 0 &&
+                   count_same_at(g, i, n, dir + 1, neighbour) == 0) {
+            edit_player(g, neighbour)->always_free_fields += 1;
         }
 
-        field_t *field = get_field(g, x, y);
+    }
+}
+
+#define BLOCKED_LABEL (MAX_SEARCHES + 1)
 
-        if (!field->player &&
-            count_same_players(g, x, y, p, 0) == 0) {
-            p->always_free_fields -= 1;
-        } else if (field->player &&
-                   count_same_players(g, field_x, field_y, field->player, dir + 1) == 0) {
-            field->player->always_free_fields += 1;
-        }
+// Plansze o większej liczbie pól przechowują etykiety w tablicy haszującej.
+#define DIRECT_LABELS_FIELDS ((uint64_t) 1 << 26)
 
+// Wpis tablicy haszującej: znacznik przeszukiwania, indeks pola i etykieta.
+#define LABEL_BITS 4
+#define LABEL_MASK (((uint64_t) 1 << LABEL_BITS) - 1)
+#define STAMP_SHIFT 48
+#define MIN_MARKS_BITS 6
+
+static bool reserve_queue(scratch_t *s, uint8_t i, uint64_t size) {
+    if (size <= s->capacity[i]) {
+        return true;
     }
+    uint64_t capacity = s->capacity[i] > 0 ? 2 * s->capacity[i] : 64;
+    if (capacity < size) {
+        capacity = size;
+    }
+    position_t *queue = realloc(s->queue[i], capacity * sizeof(position_t));
+    if (!queue) {
+        return false;
+    }
+    s->queue[i] = queue;
+    s->capacity[i] = capacity;
+    return true;
 }
 
-static void update_parent_dfs(gamma_t *g, uint32_t field_x, uint32_t field_y,
-                              field_t *new_parent, uint64_t update_time) {
-    field_t *f = get_field(g, field_x, field_y);
+static bool live_mark(scratch_t *s, uint64_t entry) {
+    return entry >> STAMP_SHIFT == s->stamp && (entry & LABEL_MASK) != 0;
+}
 
-    if (f == new_parent) {
-        f->parent = NULL;
-    } else {
-        f->parent = new_parent;
+static uint64_t *find_mark(scratch_t *s, uint64_t i) {
+    uint64_t mask = ((uint64_t) 1 << s->marks_bits) - 1;
+    uint64_t slot = i * 0x9E3779B97F4A7C15u >> (64 - s->marks_bits);
+    while (live_mark(s, s->marks[slot]) &&
+           (s->marks[slot] & (((uint64_t) 1 << STAMP_SHIFT) - 1)) >>
+           LABEL_BITS != i) {
+        slot = (slot + 1) & mask;
     }
+    return s->marks + slot;
+}
 
-    f->last_updated = update_time;
+static uint8_t get_label(scratch_t *s, uint64_t i) {
+    if (s->labels) {
+        return s->labels[i];
+    }
+    uint64_t entry = *find_mark(s, i);
+    return live_mark(s, entry) ? (uint8_t) (entry & LABEL_MASK) : 0;
+}
 
-    uint32_t x, y;
-    for (dir_t dir = DIR_START; dir < DIR_END; dir++) {
-        if (!get_position(g, field_x, field_y, dir, &x, &y)) {
-            continue;
-        }
+static void set_label(scratch_t *s, uint64_t i, uint8_t label) {
+    if (s->labels) {
+        s->labels[i] = label;
+        return;
+    }
+    uint64_t *entry = find_mark(s, i);
+    if (!live_mark(s, *entry)) {
+        s->marked++;
+    }
+    *entry = (uint64_t) s->stamp << STAMP_SHIFT | i << LABEL_BITS | label;
+}
 
-        field_t *field = get_field(g, x, y);
+static void clear_labels(gamma_t *g, scratch_t *s, const position_t *queue,
+                         uint64_t length) {
+    for (uint64_t i = 0; s->labels && i < length; i++) {
+        s->labels[get_index(g, queue[i].x, queue[i].y)] = 0;
+    }
+}
 
-        if (field->player != f->player || field->last_updated == update_time) {
-            continue;
+static void finish_search(scratch_t *s) {
+    if (!s->marks) {
+        return;
+    }
+    s->marked = 0;
+    if (++s->stamp == 0) {
+        memset(s->marks, 0, sizeof(uint64_t) << s->marks_bits);
+    }
+}
+
+static bool reserve_labels(gamma_t *g, scratch_t *s, uint64_t size) {
+    uint64_t fields = (uint64_t) g->board_width * g->board_height;
+    if (s->labels && s->fields != fields) {
+        free(s->labels);
+        s->labels = NULL;
+    }
+    if (fields <= DIRECT_LABELS_FIELDS) {
+        if (!s->labels) {
+            s->labels = calloc(fields, sizeof(uint8_t));
+            s->fields = fields;
+        }
+        return s->labels != NULL;
+    }
+
+    uint64_t needed = 2 * (s->marked + size);
+    if (s->marks && needed <= (uint64_t) 1 << s->marks_bits) {
+        return true;
+    }
+    uint8_t bits = MIN_MARKS_BITS;
+    while (((uint64_t) 1 << bits) < needed) {
+        bits++;
+    }
+    uint64_t *marks = calloc((uint64_t) 1 << bits, sizeof(uint64_t));
+    if (!marks) {
+        return false;
+    }
+    scratch_t old = *s;
+    s->marks = marks;
+    s->marks_bits = bits;
+    s->marked = 0;
+    for (uint64_t i = 0; old.marks && i < (uint64_t) 1 << old.marks_bits;
+         i++) {
+        if (live_mark(s, old.marks[i])) {
+            set_label(s, (old.marks[i] & (((uint64_t) 1 << STAMP_SHIFT) - 1))
+                         >> LABEL_BITS, (uint8_t) (old.marks[i] & LABEL_MASK));
         }
+    }
+    free(old.marks);
+    return true;
+}
+
+bool reserve_scratch(gamma_t *g, scratch_t *s, uint64_t size) {
+    return reserve_labels(g, s, size + 1) && reserve_queue(s, 0, size);
+}
+
+static void update_area_parent(gamma_t *g, scratch_t *s, uint64_t *length,
+                               uint32_t root_x, uint32_t root_y) {
+    uint64_t root = get_index(g, root_x, root_y);
+    uint32_t owner = owner_at(g, root);
+    position_t *queue = s->queue[0];
+    uint64_t head = *length;
+    uint64_t start = *length;
+
+    set_parent(g, root, root);
+    set_rank(g, root, 0);
+    set_label(s, root, 1);
+    queue[(*length)++] = (position_t) {root_x, root_y};
+
+    while (head < *length) {
+        position_t pos = queue[head++];
+        uint64_t j = get_index(g, pos.x, pos.y);
+        const neighbourhood_t *n = get_neighbourhood(g, pos.x, pos.y);
+        for (uint8_t dir = 0; dir < n->count; dir++) {
+            uint64_t i = neighbour_at(n, j, dir);
 
-        update_parent_dfs(g, x, y, new_parent, update_time);
+            if (owner_at(g, i) != owner || get_label(s, i) != 0) {
+                continue;
+            }
 
+            set_label(s, i, 1);
+            set_parent(g, i, root);
+            set_rank(g, i, 0);
+            queue[(*length)++] = (position_t) {pos.x + n->dx[dir],
+                                               pos.y + n->dy[dir]};
+        }
+    }
+    if (*length - start > 1) {
+        set_rank(g, root, 1);
     }
+    COUNT(g, rebuild_visits, *length - start);
 }
 
 void remove_field(gamma_t *g, uint32_t field_x, uint32_t field_y) {
-    field_t *f = get_field(g, field_x, field_y);
-    f->player->busy_areas -= 1;
-    f->player->busy_fields -= 1;
+    uint32_t owner = get_owner(g, field_x, field_y);
+    player_t *p = edit_player(g, owner);
+    p->busy_areas -= 1;
+    p->busy_fields -= 1;
     g->all_free_fields += 1;
 
-    player_t *p = f->player;
-
-    f->player = NULL;
+    update_owner(g, field_x, field_y, 0);
     if (p->busy_fields == 0) {
         g->active_players -= 1;
     }
 
-    remove_always_free(g, field_x, field_y, p);
+    remove_always_free(g, field_x, field_y, owner);
 
-    uint64_t update_time = g->last_update_time;
-    g->last_update_time += 1;
+    scratch_t *s = &g->scratch;
+    uint64_t length = 0;
 
+    uint64_t j = get_index(g, field_x, field_y);
+    const neighbourhood_t *n = get_neighbourhood(g, field_x, field_y);
+    for (uint8_t dir = 0; dir < n->count; dir++) {
+        uint64_t i = neighbour_at(n, j, dir);
 
-    uint32_t x, y;
-    for (dir_t dir = DIR_START; dir < DIR_END; dir++) {
-        if (!get_position(g, field_x, field_y, dir, &x, &y)) {
+        if (owner_at(g, i) != owner || get_label(s, i) != 0) {
             continue;
         }
 
-        field_t *field = get_field(g, x, y);
+        p->busy_areas += 1;
+        update_area_parent(g, s, &length, field_x + n->dx[dir],
+                           field_y + n->dy[dir]);
+    }
+
+    clear_labels(g, s, s->queue[0], length);
+    finish_search(s);
+}
 
-        if (field->player != p || field->last_updated == update_time) {
+bool own_placement(gamma_t *g, uint32_t player, uint32_t field_x,
+                   uint32_t field_y) {
+    uint64_t i = get_index(g, field_x, field_y);
+    if (!chunks_own(&g->chunks, i) ||
+        !bitplanes_own(&g->planes, field_y)) {
+        return false;
+    }
+    if (!g->chunks.shared) {
+        return true;
+    }
+
+    const neighbourhood_t *n = get_neighbourhood(g, field_x, field_y);
+    for (uint8_t dir = 0; dir < n->count; dir++) {
+        uint64_t j = neighbour_at(n, i, dir);
+        if (owner_at(g, j) != player) {
             continue;
         }
+        if (!chunks_own(&g->chunks, peek_area_root(g, j))) {
+            return false;
+        }
+    }
+    return true;
+}
 
-        p->busy_areas += 1;
-        update_parent_dfs(g, x, y, field, update_time);
+bool own_removal(gamma_t *g, uint32_t field_x, uint32_t field_y) {
+    if (!g->chunks.shared) {
+        return true;
+    }
+    if (!bitplanes_own(&g->planes, field_y)) {
+        return false;
+    }
+
+    uint32_t owner = get_owner(g, field_x, field_y);
+    scratch_t *s = &g->scratch;
+    position_t *queue = s->queue[0];
+    uint64_t head = 0, length = 0;
+    bool ok = true;
+
+    set_label(s, get_index(g, field_x, field_y), 1);
+    queue[length++] = (position_t) {field_x, field_y};
+    while (ok && head < length) {
+        position_t pos = queue[head++];
+        uint64_t j = get_index(g, pos.x, pos.y);
+        const neighbourhood_t *n = get_neighbourhood(g, pos.x, pos.y);
+        ok = chunks_own(&g->chunks, j);
+        for (uint8_t dir = 0; dir < n->count; dir++) {
+            uint64_t i = neighbour_at(n, j, dir);
 
+            if (owner_at(g, i) != owner || get_label(s, i) != 0) {
+                continue;
+            }
+
+            set_label(s, i, 1);
+            queue[length++] = (position_t) {pos.x + n->dx[dir],
+                                            pos.y + n->dy[dir]};
+        }
+    }
+
+    clear_labels(g, s, queue, length);
+    finish_search(s);
+    return ok;
+}
+
+static uint8_t find_search_root(uint8_t *roots, uint8_t i) {
+    while (roots[i] != i) {
+        i = roots[i];
+    }
+    return i;
+}
+
+uint8_t count_split_areas(gamma_t *g, scratch_t *s, uint32_t field_x,
+                          uint32_t field_y, uint8_t limit) {
+    if (!reserve_labels(g, s, 1)) {
+        return UINT8_MAX;
+    }
+
+    uint64_t field = get_index(g, field_x, field_y);
+    uint32_t owner = owner_at(g, field);
+    uint64_t head[MAX_SEARCHES] = {0}, length[MAX_SEARCHES] = {0};
+    uint8_t roots[MAX_SEARCHES];
+    uint8_t searches = 0;
+    bool failed = false;
+
+    set_label(s, field, BLOCKED_LABEL);
+
+    const neighbourhood_t *n = get_neighbourhood(g, field_x, field_y);
+    for (uint8_t dir = 0; dir < n->count; dir++) {
+        uint64_t j = neighbour_at(n, field, dir);
+        if (owner_at(g, j) != owner) {
+            continue;
+        }
+        if (!reserve_labels(g, s, 1) || !reserve_queue(s, searches, 1)) {
+            failed = true;
+            break;
+        }
+        s->queue[searches][0] = (position_t) {field_x + n->dx[dir],
+                                              field_y + n->dy[dir]};
+        set_label(s, j, searches + 1);
+        length[searches] = 1;
+        roots[searches] = searches;
+        searches++;
+    }
+
+    uint8_t parts = 0;
+    bool counted[MAX_SEARCHES] = {false};
+    while (!failed && searches > 1) {
+        for (uint8_t i = 0; i < searches && !failed; i++) {
+            if (head[i] == length[i]) {
+                continue;
+            }
+            position_t pos = s->queue[i][head[i]++];
+            uint64_t k = get_index(g, pos.x, pos.y);
+            const neighbourhood_t *around = get_neighbourhood(g, pos.x, pos.y);
+            for (uint8_t dir = 0; dir < around->count; dir++) {
+                uint64_t j = neighbour_at(around, k, dir);
+                if (owner_at(g, j) != owner) {
+                    continue;
+                }
+                uint8_t label = get_label(s, j);
+                if (label == 0) {
+                    if (!reserve_labels(g, s, 1) ||
+                        !reserve_queue(s, i, length[i] + 1)) {
+                        failed = true;
+                        break;
+                    }
+                    set_label(s, j, i + 1);
+                    s->queue[i][length[i]++] = (position_t) {
+                            pos.x + around->dx[dir], pos.y + around->dy[dir]};
+                } else if (label != BLOCKED_LABEL) {
+                    uint8_t a = find_search_root(roots, i);
+                    uint8_t b = find_search_root(roots, label - 1);
+                    roots[a] = b;
+                }
+            }
+        }
+
+        bool active[MAX_SEARCHES] = {false};
+        for (uint8_t i = 0; i < searches; i++) {
+            if (head[i] < length[i]) {
+                active[find_search_root(roots, i)] = true;
+            }
+        }
+        uint8_t live = 0;
+        for (uint8_t i = 0; i < searches; i++) {
+            if (roots[i] != i || counted[i]) {
+                continue;
+            }
+            if (active[i]) {
+                live++;
+            } else {
+                counted[i] = true;
+                parts++;
+            }
+        }
+        if (live <= 1 || parts >= limit) {
+            parts += live > 0;
+            break;
+        }
+    }
+
+    if (searches <= 1) {
+        parts = searches;
+    }
+
+    for (uint8_t i = 0; i < searches; i++) {
+        clear_labels(g, s, s->queue[i], length[i]);
+    }
+    if (s->labels) {
+        s->labels[field] = 0;
+    }
+    finish_search(s);
+    COUNT(g, split_searches, 1);
+    for (uint8_t i = 0; i < searches; i++) {
+        COUNT(g, split_visits, length[i]);
+    }
+
+    return failed ? UINT8_MAX : parts;
+}
+
+void free_scratch(scratch_t *s) {
+    free(s->labels);
+    free(s->marks);
+    for (uint8_t i = 0; i < MAX_SEARCHES; i++) {
+        free(s->queue[i]);
     }
 }
 
@@ -228,6 +858,49 @@ uint32_t get_field_size(uint32_t n) {
     return result;
 }
 
+static const char digit_pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+char *write_row(gamma_t *g, char *buffer, uint32_t field_width,
+                uint32_t x_begin, uint32_t x_end, uint32_t y) {
+    uint64_t row = get_index(g, 0, y);
+    for (uint32_t x = x_begin; x < x_end; x++) {
+        uint32_t player = owner_at(g, row + x);
+        char *end = buffer + field_width;
+        char *c = end;
+        if (player == 0) {
+            *--c = '.';
+        } else {
+            while (player >= 100) {
+                const char *pair = digit_pairs + 2 * (player % 100);
+                player /= 100;
+                *--c = pair[1];
+                *--c = pair[0];
+            }
+            if (player >= 10) {
+                *--c = digit_pairs[2 * player + 1];
+                *--c = digit_pairs[2 * player];
+            } else {
+                *--c = (char) ('0' + player);
+            }
+        }
+        while (c > buffer) {
+            *--c = '_';
+        }
+        buffer = end;
+    }
+    return buffer;
+}
+
 bool gm_necessary(gamma_t *g, uint32_t player) {
     player_t *p = get_player(g, player);
 
@@ -235,26 +908,141 @@ bool gm_necessary(gamma_t *g, uint32_t player) {
              g->number_of_players < 2);
 }
 
-bool gm_field_possible(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
-    field_t *f = get_field(g, x, y);
+bool gm_field_possible(gamma_t *g, scratch_t *s, uint32_t player, uint32_t x,
+                       uint32_t y) {
+    uint32_t owner = get_owner(g, x, y);
     player_t *p = get_player(g, player);
 
-    if (f->player == NULL || f->player == p) {
+    COUNT(g, golden_probes, 1);
+    if (owner == 0 || owner == player) {
         return false;
     }
 
-    if (p->busy_areas == g->max_areas && count_same_players(g, x, y, p, 0) == 0) {
+    if (p->busy_areas == g->max_areas &&
+        count_same_players(g, x, y, player, 0) == 0) {
         return false;
     }
 
-    player_t *c_p = f->player;
+    if (g->topology == GAMMA_SQUARE && locally_connected(g, x, y)) {
+        return true;
+    }
+
+    // Po usunięciu pola właściciel traci jeden obszar i zyskuje tyle, na ile
+    // części rozpadnie się obszar, do którego należało pole.
+    uint64_t allowed = (uint64_t) g->max_areas + 1 -
+                       get_player(g, owner)->busy_areas;
+    uint8_t limit = allowed < MAX_SEARCHES ? (uint8_t) allowed : MAX_SEARCHES;
+
+    return count_split_areas(g, s, x, y, limit) <= allowed;
+}
+
+bool gm_possible_fast(gamma_t *g, uint32_t player, bool *result) {
+    player_t *p = get_player(g, player);
+    uint64_t all_busy_fields = (uint64_t) g->board_width * g->board_height -
+                               g->all_free_fields;
+
+    // Każdy obszar zawiera pole, którego usunięcie go nie dzieli (np. liść
+    // drzewa rozpinającego obszar), więc wystarczy dowolne pole innego gracza.
+    if (all_busy_fields == p->busy_fields) {
+        *result = false;
+        return true;
+    }
+    if (p->busy_areas < g->max_areas || p->safe_border_fields > 0) {
+        *result = true;
+        return true;
+    }
+    if (g->topology == GAMMA_SQUARE && p->border_fields == 0) {
+        *result = false;
+        return true;
+    }
+    return false;
+}
 
-    remove_field(g, x, y);
-    if (c_p->busy_areas > g->max_areas) {
-        gamma_move(g, (uint32_t) (c_p->id), x, y);
+bool gm_border_possible(gamma_t *g, scratch_t *s, uint32_t player) {
+    if (!bitplanes_enabled(&g->planes)) {
+        for (uint32_t y = 0; y < g->board_height; y++) {
+            for (uint32_t x = 0; x < g->board_width; x++) {
+                if (gm_field_possible(g, s, player, x, y)) {
+                    return true;
+                }
+            }
+        }
         return false;
     }
 
-    gamma_move(g, (uint32_t) (c_p->id), x, y);
-    return true;
-}
\ No newline at end of file
+    for (uint32_t y = 0; y < g->board_height; y++) {
+        for (uint64_t word = 0; word < g->planes.row_words; word++) {
+            uint64_t candidates = bitplanes_border_word(&g->planes, player,
+                                                        y, word);
+            while (candidates != 0) {
+                uint32_t x = (uint32_t) (64 * word) +
+                             (uint32_t) __builtin_ctzll(candidates);
+                if (gm_field_possible(g, s, player, x, y)) {
+                    return true;
+                }
+                candidates &= candidates - 1;
+            }
+        }
+    }
+    return false;
+}
+
+static void resolve_border_field(gamma_t *g, scratch_t *s, uint32_t field_x,
+                                 uint32_t field_y, bool *pending,
+                                 uint32_t *count, bool *result) {
+    uint64_t i = get_index(g, field_x, field_y);
+    uint32_t owner = owner_at(g, i);
+    if (owner == 0) {
+        return;
+    }
+
+    bool known = false, possible = false;
+    const neighbourhood_t *n = get_neighbourhood(g, field_x, field_y);
+    for (uint8_t dir = 0; dir < n->count; dir++) {
+        uint32_t player = owner_at(g, neighbour_at(n, i, dir));
+        if (player == 0 || player == owner || !pending[player - 1]) {
+            continue;
+        }
+        // Gracz sąsiaduje z polem, więc wynik zależy tylko od właściciela.
+        if (!known) {
+            possible = gm_field_possible(g, s, player, field_x, field_y);
+            known = true;
+        }
+        if (possible) {
+            pending[player - 1] = false;
+            result[player - 1] = true;
+            *count -= 1;
+        }
+    }
+}
+
+void gm_border_possible_all(gamma_t *g, scratch_t *s, bool *pending,
+                            uint32_t count, bool *result) {
+    if (!bitplanes_enabled(&g->planes)) {
+        for (uint32_t y = 0; y < g->board_height && count > 0; y++) {
+            for (uint32_t x = 0; x < g->board_width && count > 0; x++) {
+                resolve_border_field(g, s, x, y, pending, &count, result);
+            }
+        }
+        return;
+    }
+
+    for (uint32_t y = 0; y < g->board_height && count > 0; y++) {
+        for (uint64_t word = 0; word < g->planes.row_words && count > 0;
+             word++) {
+            uint64_t candidates = 0;
+            for (uint32_t p = 1; p <= g->number_of_players; p++) {
+                if (pending[p - 1]) {
+                    candidates |= bitplanes_border_word(&g->planes, p,
+                                                        y, word);
+                }
+            }
+            while (candidates != 0 && count > 0) {
+                uint32_t x = (uint32_t) (64 * word) +
+                             (uint32_t) __builtin_ctzll(candidates);
+                resolve_border_field(g, s, x, y, pending, &count, result);
+                candidates &= candidates - 1;
+            }
+        }
+    }
+}
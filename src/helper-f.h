@@ -13,6 +13,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "gamma.h"
+#include "bitplanes.h"
+#include "chunks.h"
 
 /** @brief Struktura przechowująca informacje o graczu.
  * Struktura przechowuje dane o liczbie zajętych obszarów i pól oraz informację
@@ -20,36 +22,164 @@
  * "zawsze" wolnych polach czyli o liczbie pól które gracz może zająć
  * (w standardowy sposób) nawet wtedy kiedy zajął już maksymalną liczbę
  * obszarów.
+ * Dla szybkiego sprawdzania możliwości złotego ruchu przechowywana jest
+ * liczba pól innych graczy sąsiadujących z polami gracza oraz liczba tych
+ * spośród nich, których usunięcie na pewno nie podzieli obszaru właściciela
+ * (sąsiedzi właściciela są połączeni przez pola wokół usuwanego pola).
+ * Te dwa liczniki utrzymywane są tylko dla topologii @ref GAMMA_SQUARE.
  */
 typedef struct player {
     uint32_t id;                ///< numer gracza
     uint64_t busy_fields;       ///< liczba zajętych pól
     uint64_t busy_areas;        ///< liczba zajętych obszarów
     uint64_t always_free_fields;///< liczba "zawsze" możliwych do zajęcia pól
+    uint64_t border_fields;     ///< liczba pól innych graczy sąsiadujących z graczem
+    uint64_t safe_border_fields;///< liczba takich pól niedzielących obszaru
     bool golden_move_used;      ///< odpowiada czy gracz użył już złotego ruchu
 } player_t;
 
-/** @brief Struktura przechowująca informacje o polu planszy.
- * Domyślnie kiedy pole nie jest zajęte wskaźnik player jest NULL. Pole łączy
- * się z innymi polami zajętymi przez tego samego gracza w obszar za pomocą
- * struktury zbiorów rozłącznych (stąd zmienne parent i rank). Złoty ruch
- * (zazwyczaj) zmienia obszary w grze dlatego last_updated przechowuje
- * informację o ostatniej takiej zmianie.
+/** @brief Struktura przechowująca liczniki operacji wykonanych przez silnik.
+ * Liczniki pozwalają powiązać czas wykonania ruchów z kształtem planszy.
+ * Są zwiększane tylko wtedy, gdy zostały włączone funkcją
+ * @ref gamma_counters_enable, i odczytywane funkcją @ref gamma_counters.
  */
-typedef struct field {
-    player_t *player;     ///< wskaźnik na gracza zajmującego dane pole
-    struct field *parent; ///< wskaźnik istotny dla łączenia obszarów
-    uint64_t rank;        ///< liczba istotna dla łączenia obszarów
-    uint64_t last_updated;///< "czas" ostatniej aktualizacji obszaru pola
-} field_t;
+typedef struct gamma_counters {
+    uint64_t root_finds;        ///< liczba wyszukań korzenia obszaru
+    uint64_t root_steps;        ///< łączna długość ścieżek do korzeni
+    uint64_t merges;            ///< liczba połączeń dwóch obszarów
+    uint64_t rebuild_visits;    ///< pola odwiedzone przy odbudowie obszarów
+    uint64_t golden_probes;     ///< liczba sprawdzeń pola pod złoty ruch
+    uint64_t split_searches;    ///< przeszukiwania podziału obszaru
+    uint64_t split_visits;      ///< pola odwiedzone przez te przeszukiwania
+    uint64_t neighbour_counts;  ///< liczba zliczeń sąsiadów gracza
+} gamma_counters_t;
+
+/** @brief Największa liczba sąsiadów pola planszy. */
+#define NEIGHBOURS 8
+
+/** @brief Liczba klas pól o tym samym układzie sąsiadów.
+ * Klasa pola zależy od tego, czy pole ma sąsiadów po lewej, po prawej, nad
+ * sobą i pod sobą w zwykłej siatce, oraz od parzystości numeru jego wiersza.
+ */
+#define NEIGHBOUR_CLASSES 32
+
+/** @brief Struktura opisująca sąsiadów wszystkich pól jednej klasy.
+ * Pole o indeksie i i współrzędnych (x, y) ma @p count sąsiadów, a k-ty
+ * z nich ma indeks i + offsets[k] oraz współrzędne (x + dx[k], y + dy[k])
+ * liczone modulo 2^32. Sąsiedzi, którzy istnieją na planszy, zajmują
+ * początek tablic, więc przeglądanie ich nie sprawdza brzegów planszy.
+ * Pole, które przez zawinięcie brzegów byłoby swoim sąsiadem albo
+ * sąsiadowałoby z tym samym polem dwukrotnie, jest pomijane.
+ */
+typedef struct neighbourhood {
+    uint8_t count;                  ///< liczba sąsiadów
+    int64_t offsets[NEIGHBOURS];    ///< przesunięcia indeksów sąsiadów
+    uint32_t dx[NEIGHBOURS];        ///< przesunięcia numerów kolumn
+    uint32_t dy[NEIGHBOURS];        ///< przesunięcia numerów wierszy
+} neighbourhood_t;
+
+/** @brief Maksymalna liczba jednoczesnych przeszukiwań obszarów. */
+#define MAX_SEARCHES NEIGHBOURS
+
+/** @brief Struktura przechowująca współrzędne pola. */
+typedef struct position {
+    uint32_t x; ///< numer kolumny
+    uint32_t y; ///< numer wiersza
+} position_t;
+
+/** @brief Struktura przechowująca bufory pomocnicze przeszukiwania obszarów.
+ * Przeszukiwania nie zapisują niczego na planszy: odwiedzone pola oznaczane
+ * są w tablicy etykiet, która po każdym przeszukiwaniu jest czyszczona na
+ * podstawie zawartości kolejek. Bufory są alokowane przy pierwszym użyciu
+ * i wykorzystywane ponownie, więc kolejne przeszukiwania nie alokują
+ * pamięci. Każdy wątek czytający stan gry może używać własnej struktury,
+ * a jedna struktura może służyć kolejno różnym grom.
+ * Rozmiar buforów jest ograniczony: tablica etykiet zajmuje 1 bajt na każde
+ * pole planszy, a każda kolejka 8 bajtów na pole przeszukiwanego obszaru.
+ * Na planszach, dla których tablica etykiet byłaby zbyt duża, etykiety
+ * przechowywane są w tablicy haszującej o rozmiarze zależnym od liczby
+ * odwiedzonych pól, a zamiast czyszczenia zmieniany jest znacznik
+ * przeszukiwania zapisywany w każdym wpisie.
+ */
+typedef struct scratch {
+    uint8_t *labels;                 ///< etykiety pól, 0 - pole nieodwiedzone
+    uint64_t fields;                 ///< liczba pól planszy tablicy etykiet
+    uint64_t *marks;                 ///< tablica haszująca etykiet lub NULL
+    uint8_t marks_bits;              ///< logarytm rozmiaru tablicy haszującej
+    uint16_t stamp;                  ///< znacznik bieżącego przeszukiwania
+    uint64_t marked;                 ///< liczba etykiet bieżącego przeszukiwania
+    position_t *queue[MAX_SEARCHES]; ///< kolejki kolejnych przeszukiwań
+    uint64_t capacity[MAX_SEARCHES]; ///< rozmiary zaalokowanych kolejek
+} scratch_t;
+
+/** @brief Rodzaje wpisów w dzienniku ruchów. */
+typedef enum journal_kind {
+    JOURNAL_MOVE,           ///< początek zwykłego ruchu
+    JOURNAL_GOLDEN_MOVE,    ///< początek złotego ruchu
+    JOURNAL_GAME,           ///< liczniki gry sprzed ruchu
+    JOURNAL_OWNER,          ///< poprzedni gracz na polu
+    JOURNAL_PARENT,         ///< poprzedni rodzic pola w obszarze
+    JOURNAL_RANK,           ///< poprzednia ranga pola w obszarze
+    JOURNAL_PLAYER          ///< poprzednie liczniki gracza
+} journal_kind_t;
+
+/** @brief Struktura przechowująca jeden wpis w dzienniku ruchów.
+ * Wpis początku ruchu przechowuje numer gracza w @p index i współrzędne
+ * pola w @p value, wpis liczników gry liczbę aktywnych graczy w @p index
+ * i liczbę wolnych pól w @p value, a wpis liczników gracza numer gracza
+ * w @p index i pozycję kopii jego liczników w @p value. Pozostałe wpisy
+ * przechowują indeks pola i poprzednią wartość.
+ */
+typedef struct journal_entry {
+    uint32_t kind;          ///< rodzaj wpisu
+    uint64_t index;         ///< indeks pola lub numer gracza
+    uint64_t value;         ///< poprzednia wartość
+} journal_entry_t;
+
+/** @brief Struktura przechowująca dziennik ruchów.
+ * Każdy ruch wykonany przy włączonym dzienniku zapisuje wpis początku ruchu,
+ * a po nim poprzednie wartości wszystkich zmienianych elementów stanu gry.
+ * Liczniki gracza kopiowane są tylko przy pierwszej zmianie w danym ruchu,
+ * co rozpoznawane jest po numerze ruchu zapisanym w @p stamps. Cofnięcie
+ * ruchu przywraca wpisy od końca, więc kosztuje tyle samo co sam ruch.
+ * Cofnięte ruchy trafiają na stos @p redo, który czyszczony jest przy
+ * wykonaniu nowego ruchu. Jeśli zabraknie pamięci na wpis, to dziennik jest
+ * czyszczony i do końca bieżącego ruchu nie przyjmuje wpisów.
+ */
+typedef struct journal {
+    bool enabled;               ///< czy dziennik jest włączony
+    bool failed;                ///< czy bieżący ruch nie zmieścił się w dzienniku
+    journal_entry_t *entries;   ///< wpisy wykonanych ruchów
+    uint64_t length;            ///< liczba wpisów
+    uint64_t capacity;          ///< rozmiar tablicy wpisów
+    player_t *players;          ///< kopie liczników graczy
+    uint64_t players_length;    ///< liczba kopii liczników
+    uint64_t players_capacity;  ///< rozmiar tablicy kopii
+    uint64_t *stamps;           ///< numery ruchów ostatnich kopii liczników
+    uint64_t moves;             ///< numer bieżącego ruchu
+    journal_entry_t *redo;      ///< wpisy początku cofniętych ruchów
+    uint64_t redo_length;       ///< liczba cofniętych ruchów
+    uint64_t redo_capacity;     ///< rozmiar tablicy cofniętych ruchów
+} journal_t;
 
 /** @brief Struktura przechowująca stan gry.
  * Struktura przechowuje podstawowe informacje o grze takie jak: szerokość i
  * wysokość planszy, liczbę graczy, maksymalną liczbę obszarów oraz wskaźniki
  * na planszę i graczy. Dodatkowo przechowywane są informacje pomocnicze dla
  * funkcji takie jak: liczba aktywnych graczy (ile graczy ma chociaż jednego
- * pionka na planszy), ostatni "czas" aktualizacji obszarów (przy złotym
- * ruchu) oraz całkowitą liczbę niezajętych przez nikogo pól.
+ * pionka na planszy) oraz całkowitą liczbę niezajętych przez nikogo pól.
+ * Plansza przechowywana jest jako osobne tablice indeksowane numerem pola
+ * (@ref get_index): numer gracza zajmującego pole (0 dla pola wolnego) oraz
+ * indeks rodzica i ranga pola w strukturze zbiorów rozłącznych łączącej pola
+ * w obszary. Korzeń obszaru jest swoim własnym rodzicem. Indeksy pól są
+ * 64-bitowe, pole zajmuje 13 bajtów, a liczba pól planszy nie może
+ * przekraczać @ref MAX_FIELDS. Tablice
+ * podzielone są na fragmenty (@ref chunks_t), które kopie gry utworzone
+ * funkcją @ref gamma_clone współdzielą do pierwszej zmiany. Sąsiedzi pola
+ * zależą od topologii planszy (@ref gamma_topology_t) i są opisani tablicą
+ * przesunięć indeksów dla klasy pola (@ref set_neighbours), więc
+ * przeglądanie sąsiadów sprawdza brzegi planszy raz dla całego pola zamiast
+ * dla każdego sąsiada.
  */
 typedef struct gamma {
     uint32_t board_width;      ///< szerokość planszy
@@ -57,24 +187,129 @@ typedef struct gamma {
     uint32_t number_of_players;///< liczba graczy
     uint32_t active_players;   ///< liczba różnych pionków na planszy
     uint32_t max_areas;        ///< maksymalna liczba obszarów
-    uint64_t last_update_time; ///< ostatni "czas" aktualizacji obszarów
     uint64_t all_free_fields;  ///< całkowita liczba niezajętych pól
+    uint8_t topology;          ///< topologia planszy (@ref gamma_topology_t)
     player_t *players;         ///< tablica przechowująca wskaźniki na graczy
-    field_t *board;            ///< tablica przechowująca wskaźniki na pola
+    chunks_t chunks;           ///< fragmenty tablic pól planszy
+    bitplanes_t planes;        ///< bitowe mapy zajętości zwykłej siatki
+    scratch_t scratch;         ///< bufory pomocnicze przeszukiwania obszarów
+    journal_t journal;         ///< dziennik ruchów
+    bool counting;             ///< czy liczniki operacji są włączone
+    gamma_counters_t counters; ///< liczniki operacji silnika
+    neighbourhood_t neighbours[NEIGHBOUR_CLASSES]; ///< sąsiedzi klas pól
 } gamma_t;
 
+/** @brief Maksymalna liczba pól planszy.
+ * Arena takiej planszy zajmuje około 13 TiB przestrzeni adresowej i pliku,
+ * więc mieści się w 47-bitowej przestrzeni adresowej procesu i w
+ * ograniczeniu rozmiaru pliku popularnych systemów plików (16 TiB).
+ * Plansze większe niż UINT32_MAX pól można tworzyć tylko funkcją
+ * @ref gamma_new_file.
+ */
+#define MAX_FIELDS ((uint64_t) 1 << 40)
+
+/** @brief Zwiększa licznik operacji silnika, jeśli liczniki są włączone.
+ * @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] counter - nazwa pola struktury @ref gamma_counters_t,
+ * @param[in] n       - wartość dodawana do licznika.
+ */
+#define COUNT(g, counter, n) \
+    do { \
+        if ((g)->counting) { \
+            (g)->counters.counter += (n); \
+        } \
+    } while (0)
+
 /** @brief Zwraca wskaźnik na gracza o danym numerze.
  * @param[in] g       - wskaźnik na strukturę przechowującą stan gry,
  * @param[in] p       - numer gracza.
  */
 player_t *get_player(gamma_t *g, uint32_t p);
 
-/** @brief Zwraca wskaźnik na pole o danych współrzędnych.
+/** @brief Zwraca wskaźnik na gracza, którego liczniki zostaną zmienione.
+ * Przy włączonym dzienniku ruchów zapisuje w nim liczniki gracza sprzed
+ * zmiany.
+ * @param[in] g       - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] p       - numer gracza.
+ */
+player_t *edit_player(gamma_t *g, uint32_t p);
+
+/** @brief Zwraca indeks pola o danych współrzędnych w tablicach planszy.
  * @param[in] g       - wskaźnik na strukturę przechowującą stan gry,
  * @param[in] x       - numer kolumny,
  * @param[in] y       - numer wiersza.
  */
-field_t *get_field(gamma_t *g, uint32_t x, uint32_t y);
+uint64_t get_index(gamma_t *g, uint32_t x, uint32_t y);
+
+/** @brief Wyznacza sąsiadów pól wszystkich klas.
+ * Musi być wywołana po ustawieniu wymiarów i topologii planszy. W zwykłej
+ * siatce sąsiedzi pola o indeksie i mają indeksy i - 1, i - szerokość,
+ * i + 1 oraz i + szerokość, o ile pole nie leży na odpowiednim brzegu
+ * planszy. Pozostałe topologie dodają sąsiadów po skosie albo zawijają
+ * brzegi planszy.
+ * @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry.
+ */
+void set_neighbours(gamma_t *g);
+
+/** @brief Wyznacza współrzędne pola o danym indeksie w tablicach planszy.
+ * @param[in] g       - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] index   - indeks pola,
+ * @param[out] x      - wskaźnik na numer kolumny,
+ * @param[out] y      - wskaźnik na numer wiersza.
+ */
+void get_coordinates(gamma_t *g, uint64_t index, uint32_t *x, uint32_t *y);
+
+/** @brief Zwraca fragment tablic planszy zawierający pole o danym indeksie.
+ * Pole leży we fragmencie pod indeksem @p index & @ref CHUNK_MASK.
+ * @param[in] g       - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] index   - indeks pola.
+ */
+chunk_slot_t *get_chunk(gamma_t *g, uint64_t index);
+
+/** @brief Zwraca numer gracza zajmującego pole o danych współrzędnych.
+ * @param[in] g       - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       - numer kolumny,
+ * @param[in] y       - numer wiersza.
+ * @return Numer gracza lub 0, jeśli pole jest wolne.
+ */
+uint32_t get_owner(gamma_t *g, uint32_t x, uint32_t y);
+
+/** @brief Ustawia numer gracza zajmującego pole o danych współrzędnych.
+ * @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       - numer kolumny,
+ * @param[in] y       - numer wiersza,
+ * @param[in] player  - numer gracza lub 0, jeśli pole ma być wolne.
+ */
+void set_owner(gamma_t *g, uint32_t x, uint32_t y, uint32_t player);
+
+/** @brief Przygotowuje do zmiany fragmenty planszy zmieniane przez ruch.
+ * Zapewnia, że postawienie pionka gracza @p player na polu (@p x, @p y)
+ * zmieni tylko fragmenty tablic pól i bloki map bitowych, których nie
+ * współdzielą inne kopie gry, i alokuje fragment oraz blok pola, jeśli nic
+ * w nich jeszcze nie zapisano. Skracanie ścieżek w obszarach pomija
+ * współdzielone fragmenty, więc nie trzeba ich przygotowywać.
+ * @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  - numer gracza,
+ * @param[in] x       - numer kolumny,
+ * @param[in] y       - numer wiersza.
+ * @return Wartość @p true, jeśli udało się skopiować lub zaalokować
+ * fragmenty, a @p false, jeśli zabrakło pamięci.
+ */
+bool own_placement(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
+
+/** @brief Przygotowuje do zmiany fragmenty planszy zmieniane przez usunięcie.
+ * Odpowiednik @ref own_placement dla usunięcia pionka z pola (@p x, @p y),
+ * które zmienia rodziców wszystkich pól obszaru. Jeśli gra nie współdzieli
+ * żadnego fragmentu tablic pól, to obszar nie jest przeglądany. Bufory pomocnicze gry
+ * muszą być wcześniej zarezerwowane (@ref reserve_scratch) na liczbę pól
+ * właściciela pola.
+ * @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       - numer kolumny,
+ * @param[in] y       - numer wiersza.
+ * @return Wartość @p true, jeśli udało się skopiować współdzielone fragmenty,
+ * a @p false, jeśli zabrakło pamięci.
+ */
+bool own_removal(gamma_t *g, uint32_t x, uint32_t y);
 
 /** @brief Przyłącza pole gracza do sąsiednich obszarów.
  * Sprawdza czy gracze na polach sąsiednich do pola (@p x, @p y) są tacy
@@ -87,17 +322,18 @@ field_t *get_field(gamma_t *g, uint32_t x, uint32_t y);
 void merge_with_areas(gamma_t *g, uint32_t x, uint32_t y);
 
 /** @brief Liczy ilość sąsiednich pól zajętych przez tego samego gracza.
- * Liczy ile sąsiednich pól pola (@p x, @p y) jest zajętych przez gracza @p p,
- * licząc od lewego sąsiada do dolnego sąsiada zgodnie z ruchem wskazówek
- * zegara, z pominięciem liczenia dla pierwszych @p start pól. Jeśli
+ * Liczy ile sąsiednich pól pola (@p x, @p y) jest zajętych przez gracza
+ * @p player,
+ * licząc sąsiadów w kolejności z tablicy sąsiadów pola (@ref neighbourhood_t),
+ * z pominięciem liczenia dla pierwszych @p start pól. Jeśli
  * @p start = 0 to pod uwagę brani są wszyscy sąsiedzi.
  * @param[in] g       - wskaźnik na strukturę przechowującą stan gry,
  * @param[in] x       - numer kolumny,
  * @param[in] y       - numer wiersza,
- * @param[in] p       - wskaźnik na gracza,
+ * @param[in] player  - numer gracza,
  * @param[in] start   - ilość pominiętych początkowych sąsiadów.
  */
-uint8_t count_same_players(gamma_t *g, uint32_t x, uint32_t y, player_t *p,
+uint8_t count_same_players(gamma_t *g, uint32_t x, uint32_t y, uint32_t player,
                            uint8_t start);
 
 /** @brief Dodaje ilość zawsze wolnych pól dla gracza stojącego na danym polu
@@ -110,22 +346,99 @@ uint8_t count_same_players(gamma_t *g, uint32_t x, uint32_t y, player_t *p,
 */
 void add_always_free(gamma_t *g, uint32_t x, uint32_t y);
 
+/** @brief Ustawia gracza na polu, aktualizując liczniki pól granicznych.
+* Zmiana zawartości pola wpływa na wkład pól z kwadratu 3x3 o środku w polu
+* (@p x, @p y) do liczników border_fields oraz safe_border_fields graczy.
+* Funkcja odczytuje raz otoczenie 5x5 pola, odejmuje dotychczasowy wkład,
+* zmienia pole i dodaje nowy wkład. W pozostałych topologiach liczniki nie są
+* utrzymywane i funkcja tylko zmienia pole.
+* @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry,
+* @param[in] x       - numer kolumny,
+* @param[in] y       - numer wiersza,
+* @param[in] player  - numer gracza lub 0, jeśli pole ma być wolne.
+*/
+void update_owner(gamma_t *g, uint32_t x, uint32_t y, uint32_t player);
+
+/** @brief Rezerwuje bufory pomocnicze dla przeszukiwania obszaru.
+* Zapewnia, że etykiety i pierwsza kolejka pomieszczą @p size pól.
+* @param[in] g       - wskaźnik na strukturę przechowującą stan gry,
+* @param[in,out] s   - wskaźnik na bufory pomocnicze,
+* @param[in] size    - liczba pól, które musi pomieścić kolejka.
+* @return Wartość @p true, jeśli udało się zaalokować pamięć,
+* a @p false w przeciwnym przypadku.
+*/
+bool reserve_scratch(gamma_t *g, scratch_t *s, uint64_t size);
+
 /** @brief Usuwa z planszy pionek gracza
 * Usuwa z planszy pionek gracza na pozycji (@p x, @p y). Aktualizowana jest
 * liczba zajętych przez gracza pól, obszarów oraz pozostałych parametrów,
-* które mogą ulec zmianie przy usunięciu pionka.
+* które mogą ulec zmianie przy usunięciu pionka. Pola obszaru otrzymują
+* nowych rodziców iteracyjnie, dlatego bufory pomocnicze gry muszą być
+* wcześniej zarezerwowane (@ref reserve_scratch) na liczbę pól gracza.
 * @param[in] g       - wskaźnik na strukturę przechowującą stan gry,
 * @param[in] x       - numer kolumny,
 * @param[in] y       - numer wiersza.
 */
 void remove_field(gamma_t *g, uint32_t x, uint32_t y);
 
+/** @brief Dodaje wkład pola do liczników graczy zależnych od sąsiedztwa.
+* Wolne pole zwiększa liczbę "zawsze" wolnych pól każdego sąsiadującego
+* z nim gracza, a zajęte pole w topologii @ref GAMMA_SQUARE zwiększa liczbę
+* pól granicznych (i ewentualnie bezpiecznych pól granicznych) każdego
+* sąsiadującego z nim innego gracza. Wywołana dla wszystkich pól wyzerowanych
+* liczników odtwarza ich wartości. Numery graczy na polach muszą być poprawne.
+* @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry,
+* @param[in] x       - numer kolumny,
+* @param[in] y       - numer wiersza.
+*/
+void add_field_counters(gamma_t *g, uint32_t x, uint32_t y);
+
+/** @brief Liczy na ile obszarów rozpadnie się obszar po usunięciu pola.
+* Nie modyfikuje planszy. Przeszukuje obszar gracza stojącego na polu
+* (@p x, @p y) jednocześnie od każdego z sąsiadów tego gracza, pomijając samo
+* pole, dopóki przeszukiwania się nie spotkają lub nie wyczerpią. Dzięki temu
+* koszt jest proporcjonalny do najmniejszych z powstających części.
+* Przeszukiwanie kończy się wcześniej, gdy wynik przekroczy @p limit.
+* @param[in] g       - wskaźnik na strukturę przechowującą stan gry,
+* @param[in,out] s   - wskaźnik na bufory pomocnicze,
+* @param[in] x       - numer kolumny,
+* @param[in] y       - numer wiersza,
+* @param[in] limit   - wartość, po przekroczeniu której można przerwać liczenie.
+* @return Liczba obszarów (co najwyżej @p limit + 1) lub UINT8_MAX, jeśli nie
+* udało się zaalokować pamięci.
+*/
+uint8_t count_split_areas(gamma_t *g, scratch_t *s, uint32_t x, uint32_t y,
+                          uint8_t limit);
+
+/** @brief Zwalnia bufory pomocnicze przeszukiwania obszarów.
+* @param[in,out] s   - wskaźnik na bufory pomocnicze.
+*/
+void free_scratch(scratch_t *s);
+
 /** @brief Zwraca szerokość pola gry.
 * Zwraca szerokość pola gry na podstawie podanej liczby graczy.
 * @param[in] n       - liczba graczy.
 */
 uint32_t get_field_size(uint32_t n);
 
+/** @brief Zapisuje fragment wiersza planszy.
+* Zapisuje do bufora opisy pól o numerach kolumn od @p x_begin włącznie
+* do @p x_end wyłącznie w wierszu @p y. Każde pole zajmuje @p field_width
+* znaków: numer gracza dopełniony z lewej znakami '_' albo znak '.'
+* poprzedzony znakami '_' dla pola wolnego. Funkcja nie dopisuje ani znaku
+* końca wiersza, ani znaku '\0'.
+* @param[in] g           - wskaźnik na strukturę przechowującą stan gry,
+* @param[out] buffer     - wskaźnik na miejsce w buforze, od którego
+*                          zapisywany jest fragment,
+* @param[in] field_width - szerokość pola,
+* @param[in] x_begin     - numer pierwszej kolumny,
+* @param[in] x_end       - numer kolumny za ostatnią,
+* @param[in] y           - numer wiersza.
+* @return Wskaźnik na miejsce w buforze za zapisanym fragmentem.
+*/
+char *write_row(gamma_t *g, char *buffer, uint32_t field_width,
+                uint32_t x_begin, uint32_t x_end, uint32_t y);
+
 /** @brief Sprawdza czy są spełnione warunki konieczne złotego ruchu.
  * Dla danego gracza sprawdzane są warunki konieczne dla możliwości
  * wykonania złotego ruchu. Warunki to: niewykorzystanie złotego ruchu
@@ -141,14 +454,63 @@ uint32_t get_field_size(uint32_t n);
 bool gm_necessary(gamma_t *g, uint32_t player);
 
 /** @brief Sprawdza czy możliwe jest wykonanie złotego ruchu na danym polu.
- * Symuluje wykonanie złotego ruchu na danym polu przez danego gracza.
+ * Sprawdza, bez modyfikowania planszy, czy usunięcie pionka z danego pola nie
+ * zwiększy liczby obszarów jego właściciela ponad limit. Zwraca @p false
+ * również wtedy, gdy nie udało się zaalokować buforów pomocniczych.
+ * Zmienia tylko podane bufory pomocnicze, więc wątki z własnymi buforami
+ * mogą sprawdzać tę samą grę jednocześnie.
  * @param[in] g       - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in,out] s   - wskaźnik na bufory pomocnicze,
  * @param[in] player  - numer gracza,
  * @param[in] x       - numer kolumny,
  * @param[in] y       - numer wiersza.
  * @return Wartość @p true, jeśli złoty ruch na danym polu jest możliwy,
  * a @p false w przeciwnym przypadku.
  */
-bool gm_field_possible(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
+bool gm_field_possible(gamma_t *g, scratch_t *s, uint32_t player, uint32_t x,
+                       uint32_t y);
+
+/** @brief Sprawdza czy gracz może wykonać złoty ruch bez przeglądania planszy.
+ * Na podstawie liczników graczy rozstrzyga możliwość wykonania złotego ruchu
+ * w stałym czasie. Zakłada, że warunki konieczne (@ref gm_necessary) są
+ * spełnione. Poza topologią @ref GAMMA_SQUARE rozstrzyga tylko przypadki,
+ * które nie wymagają liczników pól granicznych.
+ * @param[in] g       - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  - numer gracza,
+ * @param[out] result - wynik, jeśli udało się go rozstrzygnąć.
+ * @return Wartość @p true, jeśli wynik został rozstrzygnięty,
+ * a @p false, jeśli konieczne jest sprawdzenie pól na granicy gracza.
+ */
+bool gm_possible_fast(gamma_t *g, uint32_t player, bool *result);
+
+/** @brief Sprawdza złoty ruch na polach sąsiadujących z graczem.
+ * Szuka pola innego gracza sąsiadującego z polami gracza @p player, na którym
+ * możliwy jest złoty ruch. Jeśli utrzymywane są mapy bitowe planszy, to
+ * kandydaci wyznaczani są po 64 pola naraz, a w przeciwnym przypadku
+ * sprawdzane są wszystkie pola planszy.
+ * @param[in] g       - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in,out] s   - wskaźnik na bufory pomocnicze,
+ * @param[in] player  - numer gracza.
+ * @return Wartość @p true, jeśli złoty ruch jest możliwy,
+ * a @p false w przeciwnym przypadku.
+ */
+bool gm_border_possible(gamma_t *g, scratch_t *s, uint32_t player);
+
+/** @brief Sprawdza złoty ruch na granicach wielu graczy jednocześnie.
+ * Przegląda raz pola sąsiadujące z którymkolwiek z oczekujących graczy.
+ * Dla każdego takiego pola możliwość usunięcia pionka sprawdzana jest raz,
+ * a wynik przypisywany jest wszystkim oczekującym graczom sąsiadującym
+ * z polem. Gracz, dla którego znaleziono pole, przestaje oczekiwać.
+ * Oczekujący gracze muszą mieć zajętą maksymalną liczbę obszarów.
+ * @param[in] g           - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in,out] s       - wskaźnik na bufory pomocnicze,
+ * @param[in,out] pending - tablica oznaczająca oczekujących graczy,
+ *                          pod indeksem i dla gracza i + 1,
+ * @param[in] count       - liczba oczekujących graczy,
+ * @param[out] result     - tablica wyników, w której dla gracza, dla
+ *                          którego znaleziono pole, zapisywane jest @p true.
+ */
+void gm_border_possible_all(gamma_t *g, scratch_t *s, bool *pending,
+                            uint32_t count, bool *result);
 
 #endif /* HELPERF_H*/
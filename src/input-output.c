@@ -3,9 +3,9 @@
 
 #include "input-output.h"
 
-#define OK_CHAR "BImgbfqp"
-#define OK_CHAR_SIZE 8
-#define MAX_ARGS_NUMBER 4
+#define OK_CHAR "BImgbfqpQSC"
+#define OK_CHAR_SIZE 11
+#define MAX_ARGS_NUMBER 5
 #define ESC_CHAR 27
 #define UP_ARROW 1001
 #define DOWN_ARROW 1002
@@ -17,13 +17,58 @@
 #define TEXT_HIGHT 11
 #define PLAYER_WIDTH 6
 #define BUSY_WIDTH 11
+#define MAX_FIELD_WIDTH 10
+
+static writer_t *output(void) {
+    static writer_t writer;
+    static bool ready = false;
+    if (!ready) {
+        writer_init(&writer, STDOUT_FILENO);
+        ready = true;
+    }
+    return &writer;
+}
+
+static writer_t *errors(void) {
+    static writer_t writer;
+    static writer_t *errors_writer = NULL;
+    if (!errors_writer) {
+        if (same_sink(STDOUT_FILENO, STDERR_FILENO)) {
+            errors_writer = output();
+        } else {
+            writer_init(&writer, STDERR_FILENO);
+            errors_writer = &writer;
+        }
+    }
+    return errors_writer;
+}
+
+static void flush_output(void) {
+    writer_flush(output());
+    writer_flush(errors());
+}
 
 static void error_msg(unsigned long line_number) {
-    fprintf(stderr, "ERROR %lu\n", line_number);
+    writer_write(errors(), "ERROR ", 6);
+    writer_uint64(errors(), line_number);
+    writer_write(errors(), "\n", 1);
 }
 
 static void ok_msg(unsigned long line_number) {
-    printf("OK %lu\n", line_number);
+    writer_write(output(), "OK ", 3);
+    writer_uint64(output(), line_number);
+    writer_write(output(), "\n", 1);
+}
+
+static reader_t *input(void) {
+    static reader_t reader;
+    static bool ready = false;
+    if (!ready) {
+        reader_init(&reader, STDIN_FILENO);
+        reader.before_read = flush_output;
+        ready = true;
+    }
+    return &reader;
 }
 
 static bool is_comment(const char *buffer) {
@@ -33,9 +78,17 @@ static bool is_comment(const char *buffer) {
     return false;
 }
 
-static line_t *process_line(char *buffer, ssize_t length) {
-    if (length < 1 || isspace(buffer[0])) {
-        return NULL;
+static bool is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool process_line(const char *buffer, size_t length, line_t *l) {
+    if (length < 1 || is_space(buffer[0])) {
+        return false;
     }
     bool correct = false;
     char tab[] = OK_CHAR;
@@ -46,104 +99,147 @@ static line_t *process_line(char *buffer, ssize_t length) {
         }
     }
     if (correct == false) {
-        return NULL;
-    }
-
-    if (length > 2 && !isspace(buffer[1])) {
-        return NULL;
-    }
-
-    for (ssize_t i = 1; i < length; i++) {
-        char c = buffer[i];
-        if (!isspace(c) && (c < '0' || c > '9')) {
-            return NULL;
-        }
+        return false;
     }
 
-    line_t *l = (line_t *) calloc(1, sizeof(line_t));
-    if (!l) {
-        return NULL;
+    if (length > 2 && !is_space(buffer[1])) {
+        return false;
     }
 
     l->command = buffer[0];
     l->number_of_args = 0;
 
-    char *string = buffer + 1;
-    char *end_ptr;
-
-    for (int i = 0; i < MAX_ARGS_NUMBER + 1; i++) {
-        errno = 0;
-        uint64_t number = strtoull(string, &end_ptr, 10);
-        if (errno != 0) {
-            free(l);
-            return NULL;
+    size_t i = 1;
+    while (i < length) {
+        if (is_space(buffer[i])) {
+            i++;
+            continue;
         }
-        if (string == end_ptr) {
-            break;
+        if (!is_digit(buffer[i])) {
+            return false;
         }
-        if (i > MAX_ARGS_NUMBER - 1) {
-            free(l);
-            return NULL;
+        uint64_t number = 0;
+        while (i < length && is_digit(buffer[i])) {
+            if (number <= UINT32_MAX) {
+                number = 10 * number + (uint64_t) (buffer[i] - '0');
+            }
+            i++;
         }
-        if (number > UINT32_MAX) {
-            free(l);
-            return NULL;
+        if (number > UINT32_MAX || l->number_of_args == MAX_ARGS_NUMBER) {
+            return false;
         }
-        l->arg[i] = (uint32_t) number;
+        l->arg[l->number_of_args] = (uint32_t) number;
         l->number_of_args++;
-        string = end_ptr;
     }
 
-    return l;
+    return true;
 }
 
 char mode_selection(gamma_t **g, unsigned long *line_number) {
-    char *buffer = NULL;
-    size_t buffer_size = 0;
-    ssize_t length;
+    const char *buffer;
+    size_t length;
+    line_t l;
 
     char selected = '0';
 
-    while ((length = getline(&buffer, &buffer_size, stdin)) != -1) {
+    while (reader_line(input(), &buffer, &length)) {
         *line_number += 1;
-        if (length > 0 && is_comment(buffer)) {
+        if (is_comment(buffer)) {
             continue;
         }
-        line_t *l = process_line(buffer, length);
-        if (!l) {
+        if (!process_line(buffer, length, &l)) {
             error_msg(*line_number);
             continue;
         }
-        if ((l->command != 'B' && l->command != 'I') || l->number_of_args != 4) {
+        if ((l.command != 'B' && l.command != 'I') || l.number_of_args < 4) {
             error_msg(*line_number);
-            free(l);
             continue;
         }
-        *g = gamma_new(l->arg[0], l->arg[1], l->arg[2], l->arg[3]);
+        gamma_topology_t topology = l.number_of_args == 5 ?
+                                    (gamma_topology_t) l.arg[4] : GAMMA_SQUARE;
+        *g = gamma_new_topology(l.arg[0], l.arg[1], l.arg[2], l.arg[3],
+                                topology);
         if (!*g) {
             error_msg(*line_number);
-            free(l);
             continue;
         }
-        selected = l->command;
-        free(l);
+        selected = l.command;
         break;
     }
 
-    free(buffer);
+    flush_output();
     return selected;
 }
 
 static void result_bool(bool result) {
     if (result) {
-        printf("1\n");
+        writer_write(output(), "1\n", 2);
     } else {
-        printf("0\n");
+        writer_write(output(), "0\n", 2);
     }
 }
 
 static void result_uint64(uint64_t result) {
-    printf("%" PRIu64 "\n", result);
+    writer_uint64(output(), result);
+    writer_write(output(), "\n", 1);
+}
+
+static void result_golden_all(gamma_t *g, unsigned long line_number) {
+    bool *result = malloc(g->number_of_players * sizeof(bool));
+    if (result == NULL || !gamma_golden_possible_all(g, result)) {
+        free(result);
+        error_msg(line_number);
+        return;
+    }
+    for (uint32_t i = 0; i < g->number_of_players; i++) {
+        writer_write(output(), result[i] ? "1" : "0", 1);
+        writer_write(output(), i + 1 < g->number_of_players ? " " : "\n", 1);
+    }
+    free(result);
+}
+
+static void result_stats_all(gamma_t *g, unsigned long line_number) {
+    gamma_stats_t *stats = malloc(g->number_of_players * sizeof(gamma_stats_t));
+    if (stats == NULL || !gamma_stats_all(g, stats)) {
+        free(stats);
+        error_msg(line_number);
+        return;
+    }
+    for (uint32_t i = 0; i < g->number_of_players; i++) {
+        writer_uint64(output(), stats[i].busy_fields);
+        writer_write(output(), " ", 1);
+        writer_uint64(output(), stats[i].free_fields);
+        writer_write(output(), " ", 1);
+        writer_uint64(output(), stats[i].areas);
+        writer_write(output(), stats[i].golden_possible ? " 1\n" : " 0\n", 3);
+    }
+    free(stats);
+}
+
+static void result_counters(gamma_t *g, unsigned long line_number) {
+    gamma_counters_t c;
+    if (!gamma_counters(g, &c)) {
+        error_msg(line_number);
+        return;
+    }
+    const uint64_t values[] = {c.root_finds, c.root_steps, c.merges,
+                               c.rebuild_visits, c.golden_probes,
+                               c.split_searches, c.split_visits,
+                               c.neighbour_counts};
+    size_t count = sizeof(values) / sizeof(values[0]);
+    for (size_t i = 0; i < count; i++) {
+        writer_uint64(output(), values[i]);
+        writer_write(output(), i + 1 < count ? " " : "\n", 1);
+    }
+    gamma_counters_enable(g, true);
+}
+
+static char *new_window_buffer(gamma_t *g, frame_t *f) {
+    f->buffer_size = gamma_board_window_size(g, f->view_width, f->view_height);
+    if (f->buffer_size == 0 || f->buffer_size > SIZE_MAX) {
+        return NULL;
+    }
+    return malloc(f->buffer_size * sizeof(char));
 }
 
 static bool check_args_number(line_t *l, int correct_number, unsigned long line_number) {
@@ -157,17 +253,17 @@ static bool check_args_number(line_t *l, int correct_number, unsigned long line_
 void batch_mode(gamma_t *g, unsigned long *line_number) {
     ok_msg(*line_number);
 
-    char *buffer = NULL;
-    size_t buffer_size = 0;
-    ssize_t length;
+    const char *buffer;
+    size_t length;
+    line_t line;
+    line_t *l = &line;
 
-    while ((length = getline(&buffer, &buffer_size, stdin)) != -1) {
+    while (reader_line(input(), &buffer, &length)) {
         *line_number += 1;
-        if (length > 0 && is_comment(buffer)) {
+        if (is_comment(buffer)) {
             continue;
         }
-        line_t *l = process_line(buffer, length);
-        if (!l) {
+        if (!process_line(buffer, length, l)) {
             error_msg(*line_number);
             continue;
         }
@@ -202,172 +298,337 @@ void batch_mode(gamma_t *g, unsigned long *line_number) {
                 }
                 result_bool(gamma_golden_possible(g, l->arg[0]));
                 break;
+            case 'Q':
+                if (!check_args_number(l, 0, *line_number)) {
+                    break;
+                }
+                result_golden_all(g, *line_number);
+                break;
+            case 'S':
+                if (!check_args_number(l, 0, *line_number)) {
+                    break;
+                }
+                result_stats_all(g, *line_number);
+                break;
+            case 'C':
+                if (!check_args_number(l, 0, *line_number)) {
+                    break;
+                }
+                result_counters(g, *line_number);
+                break;
             case 'p':
                 if (!check_args_number(l, 0, *line_number)) {
                     break;
                 }
-                char *board = gamma_board(g);
-                printf("%s", board);
-                free(board);
+                writer_flush(output());
+                gamma_board_write(g, stdout);
+                fflush(stdout);
                 break;
             default:
                 error_msg(*line_number);
         }
-        free(l);
     }
-    free(buffer);
+    flush_output();
 }
 
-static bool check_console_size(gamma_t *g) {
+static uint32_t get_screen_width(gamma_t *g) {
+    uint32_t field_width = get_field_size(g->number_of_players);
+    return field_width % 2 == 1 ? 2 * field_width : field_width;
+}
+
+static bool check_console_size(gamma_t *g, frame_t *f) {
     struct winsize size;
-    ioctl(STDOUT_FILENO, TIOCGWINSZ, &size);
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0) {
+        f->view_width = g->board_width;
+        f->view_height = g->board_height;
+        return true;
+    }
 
-    uint32_t field_size = get_field_size(g->number_of_players);
-    if (field_size % 2 == 1) {
-        field_size++;
+    uint32_t screen_width = get_screen_width(g);
+    if (size.ws_col < TEXT_WIDTH || size.ws_col < screen_width + 4 ||
+        size.ws_row < 3 + TEXT_HIGHT) {
+        return false;
     }
 
-    uint32_t game_width = g->board_width * field_size + 4;
-    if (TEXT_WIDTH > game_width) {
-        game_width = TEXT_WIDTH;
+    f->view_width = (size.ws_col - 4) / screen_width;
+    if (f->view_width > g->board_width) {
+        f->view_width = g->board_width;
     }
+    f->view_height = size.ws_row - 2 - TEXT_HIGHT;
+    if (f->view_height > g->board_height) {
+        f->view_height = g->board_height;
+    }
+    return true;
+}
 
-    uint32_t game_height = g->board_height + 2 + TEXT_HIGHT;
+static uint32_t view_start(uint32_t cursor, uint32_t view, uint32_t board) {
+    uint32_t start = cursor < view / 2 ? 0 : cursor - view / 2;
+    return start > board - view ? board - view : start;
+}
 
-    if (size.ws_col < game_width || size.ws_row < game_height) {
-        return false;
+static bool follow_cursor(gamma_t *g, frame_t *f, uint32_t cursor_x, uint32_t cursor_y) {
+    bool moved = false;
+    if (!f->valid || cursor_x < f->view_x || cursor_x >= f->view_x + f->view_width) {
+        uint32_t x = view_start(cursor_x, f->view_width, g->board_width);
+        moved = moved || x != f->view_x;
+        f->view_x = x;
     }
-    return true;
+    if (!f->valid || cursor_y < f->view_y || cursor_y >= f->view_y + f->view_height) {
+        uint32_t y = view_start(cursor_y, f->view_height, g->board_height);
+        moved = moved || y != f->view_y;
+        f->view_y = y;
+    }
+    return moved;
 }
 
-static void print_horizontal_frame(uint32_t width, uint32_t field_width) {
+static void print_horizontal_frame(uint32_t width, uint32_t screen_width) {
     frame_colour();
-    uint32_t total_width = width * field_width + 4;
-    if (field_width % 2 == 1) {
-        total_width += width;
-    }
+    uint32_t total_width = width * screen_width + 4;
 
     for (uint32_t i = 0; i < total_width; i++) {
-        printf(" ");
+        screen_write(" ", 1);
     }
 
-    printf("\n");
+    screen_write("\n", 1);
 }
 
-static void print_board(gamma_t *g, uint32_t cursor_x, uint32_t cursor_y, uint32_t player) {
-    char *board = gamma_board(g);
+static uint64_t field_index(frame_t *f, uint32_t x, uint32_t y, uint32_t field_width) {
+    uint64_t row_length = (uint64_t) f->view_width * field_width + 1;
+    return (uint64_t) (f->view_y + f->view_height - 1 - y) * row_length +
+           (uint64_t) (x - f->view_x) * field_width;
+}
 
-    uint32_t field_width = get_field_size(g->number_of_players);
+static void print_field(gamma_t *g, frame_t *f, uint32_t x, uint32_t y, uint32_t cursor_x,
+                        uint32_t cursor_y, uint32_t player, uint32_t field_width) {
+    if (x % 2 == y % 2) {
+        field_colour_one();
+    } else {
+        field_colour_two();
+    }
 
-    print_horizontal_frame(g->board_width, field_width);
+    if (player != 0 && get_owner(g, x, y) == player) {
+        player_field();
+    }
+    if (player != 0 && x == cursor_x && y == cursor_y) {
+        cursor_field();
+    }
 
-    uint64_t i = 0;
-    for (uint32_t y = g->board_height; y > 0; y--) {
-        frame_colour();
-        printf("  ");
-        for (uint32_t x = 0; x < g->board_width; x++) {
-            if (x % 2 == (y - 1) % 2) {
-                field_colour_one();
-            } else {
-                field_colour_two();
-            }
+    char *field = f->board + field_index(f, x, y, field_width);
+    char text[2 * MAX_FIELD_WIDTH];
+    uint32_t length = 0;
+    for (uint32_t j = 0; j < field_width; j++) {
+        if (field_width % 2 == 1) {
+            text[length++] = ' ';
+        }
+        if (field[j] == '_' || field[j] == '.') {
+            text[length++] = ' ';
+        } else {
+            text[length++] = field[j];
+        }
+    }
+    screen_write(text, length);
 
-            player_t *field_player = get_field(g, x, y - 1)->player;
-            if (field_player != NULL && field_player->id == player) {
-                player_field();
-            }
-            if (player != 0 && x == cursor_x && y - 1 == cursor_y) {
-                cursor_field();
-            }
+    reset_colour();
+}
 
-            for (uint32_t j = 0; j < field_width; j++) {
-                if (field_width % 2 == 1) {
-                    printf(" ");
-                }
-                if (board[i] == '_' || board[i] == '.') {
-                    printf(" ");
-                } else {
-                    printf("%c", board[i]);
-                }
-                i++;
-            }
+static void move_to_field(gamma_t *g, frame_t *f, uint32_t x, uint32_t y) {
+    move_cursor(f->view_y + f->view_height + 1 - y,
+                3 + (x - f->view_x) * get_screen_width(g));
+}
 
-            reset_colour();
+static void print_board(gamma_t *g, frame_t *f, uint32_t cursor_x, uint32_t cursor_y,
+                        uint32_t player) {
+    uint32_t field_width = get_field_size(g->number_of_players);
 
-            if (x == g->board_width - 1) {
-                frame_colour();
-                printf("  ");
-            }
+    print_horizontal_frame(f->view_width, get_screen_width(g));
+
+    for (uint32_t y = f->view_y + f->view_height; y > f->view_y; y--) {
+        frame_colour();
+        screen_write("  ", 2);
+        for (uint32_t x = f->view_x; x < f->view_x + f->view_width; x++) {
+            print_field(g, f, x, y - 1, cursor_x, cursor_y, player, field_width);
         }
-        printf("\n");
-        i++;
+        frame_colour();
+        screen_write("  \n", 3);
     }
 
-    print_horizontal_frame(g->board_width, field_width);
+    print_horizontal_frame(f->view_width, get_screen_width(g));
 
     reset_colour();
-    free(board);
 }
 
-static void print_game(gamma_t *g, uint32_t cursor_x, uint32_t cursor_y, uint32_t player) {
-    clear_console();
-
-    print_board(g, cursor_x, cursor_y, player);
-
+static void print_status(uint32_t player, uint64_t free_fields, uint64_t busy_fields,
+                         bool golden) {
     bold();
-    printf("PLAYER %"PRIu32"\n", player);
+    screen_text("PLAYER ");
+    screen_uint64(player);
     reset_colour();
-    printf("> number of free fields: %"PRIu64"\n", gamma_free_fields(g, player));
-    printf("> number of busy fields: %"PRIu64"\n", gamma_busy_fields(g, player));
-    if (gamma_golden_possible(g, player)) {
-        printf("> ");
+    clear_line();
+    screen_text("\n> number of free fields: ");
+    screen_uint64(free_fields);
+    clear_line();
+    screen_text("\n> number of busy fields: ");
+    screen_uint64(busy_fields);
+    clear_line();
+    screen_write("\n", 1);
+    if (golden) {
+        screen_text("> ");
         bold();
-        printf("golden move possible\n");
+        screen_text("golden move possible");
         reset_colour();
     }
-    else {
-        printf("\n");
+    clear_line();
+    screen_write("\n", 1);
+}
+
+static void print_full_game(gamma_t *g, frame_t *f, uint32_t cursor_x, uint32_t cursor_y,
+                            uint32_t player, uint64_t free_fields, uint64_t busy_fields,
+                            bool golden) {
+    clear_console();
+
+    print_board(g, f, cursor_x, cursor_y, player);
+    print_status(player, free_fields, busy_fields, golden);
+
+    screen_text("\nUse arrows to move around the board.\n"
+                "SPACE   - make a move.\n"
+                "G       - make a golden move.\n"
+                "C       - give up a move.\n"
+                "Ctrl+D  - quit the game.\n");
+}
+
+static bool field_changed(gamma_t *g, frame_t *f, uint32_t x, uint32_t y, uint32_t cursor_x,
+                          uint32_t cursor_y, uint32_t player, uint32_t field_width) {
+    if ((x == cursor_x && y == cursor_y) || (x == f->cursor_x && y == f->cursor_y)) {
+        return true;
+    }
+    uint64_t i = field_index(f, x, y, field_width);
+    if (f->stale && memcmp(f->board + i, f->previous + i, field_width) != 0) {
+        return true;
+    }
+    if (player != f->player) {
+        uint32_t owner = get_owner(g, x, y);
+        return owner == player || owner == f->player;
+    }
+    return false;
+}
+
+static void print_changes(gamma_t *g, frame_t *f, bool moved, uint32_t cursor_x,
+                          uint32_t cursor_y, uint32_t player, uint64_t free_fields,
+                          uint64_t busy_fields, bool golden) {
+    uint32_t field_width = get_field_size(g->number_of_players);
+
+    if (moved) {
+        move_cursor(1, 1);
+        print_board(g, f, cursor_x, cursor_y, player);
+    } else if (f->stale || player != f->player) {
+        for (uint32_t y = f->view_y; y < f->view_y + f->view_height; y++) {
+            for (uint32_t x = f->view_x; x < f->view_x + f->view_width; x++) {
+                if (field_changed(g, f, x, y, cursor_x, cursor_y, player, field_width)) {
+                    move_to_field(g, f, x, y);
+                    print_field(g, f, x, y, cursor_x, cursor_y, player, field_width);
+                }
+            }
+        }
+    } else if (cursor_x != f->cursor_x || cursor_y != f->cursor_y) {
+        move_to_field(g, f, f->cursor_x, f->cursor_y);
+        print_field(g, f, f->cursor_x, f->cursor_y, cursor_x, cursor_y, player, field_width);
+        move_to_field(g, f, cursor_x, cursor_y);
+        print_field(g, f, cursor_x, cursor_y, cursor_x, cursor_y, player, field_width);
     }
 
-    printf("\nUse arrows to move around the board.\n"
-           "SPACE   - make a move.\n"
-           "G       - make a golden move.\n"
-           "C       - give up a move.\n"
-           "Ctrl+D  - quit the game.\n");
+    if (player != f->player || free_fields != f->free_fields ||
+        busy_fields != f->busy_fields || golden != f->golden) {
+        move_cursor(f->view_height + 3, 1);
+        print_status(player, free_fields, busy_fields, golden);
+    }
 }
 
-static void end_of_game(gamma_t *g) {
+static void print_game(gamma_t *g, frame_t *f, uint32_t cursor_x, uint32_t cursor_y,
+                       uint32_t player, bool golden) {
+    uint64_t free_fields = gamma_free_fields(g, player);
+    uint64_t busy_fields = gamma_busy_fields(g, player);
+
+    bool moved = follow_cursor(g, f, cursor_x, cursor_y);
+    if (f->stale || !f->valid || moved) {
+        char *previous = f->previous;
+        f->previous = f->board;
+        f->board = previous;
+        gamma_board_window_into(g, f->view_x, f->view_y, f->view_width, f->view_height,
+                                f->board, f->buffer_size);
+    }
+
+    if (f->valid) {
+        print_changes(g, f, moved, cursor_x, cursor_y, player, free_fields, busy_fields,
+                      golden);
+    } else {
+        print_full_game(g, f, cursor_x, cursor_y, player, free_fields, busy_fields, golden);
+    }
+
+    f->valid = true;
+    f->stale = false;
+    f->cursor_x = cursor_x;
+    f->cursor_y = cursor_y;
+    f->player = player;
+    f->free_fields = free_fields;
+    f->busy_fields = busy_fields;
+    f->golden = golden;
+}
+
+static void end_of_game(gamma_t *g, frame_t *f) {
     clear_console();
-    print_board(g, 0, 0, 0);
+    gamma_board_window_into(g, f->view_x, f->view_y, f->view_width, f->view_height,
+                            f->board, f->buffer_size);
+    print_board(g, f, 0, 0, 0);
     bold();
-    printf("Game over!\n");
+    screen_text("Game over!\n");
 
     uint64_t best_score = 0;
 
-    printf("PLAYER | BUSY FIELDS\n");
+    screen_text("PLAYER | BUSY FIELDS\n");
     reset_colour();
 
-    for(uint32_t i = 1; i <= g->number_of_players; i++) {
-        if(gamma_busy_fields(g, i) > best_score) {
-            best_score = gamma_busy_fields(g, i);
+    gamma_stats_t *stats = malloc(g->number_of_players * sizeof(gamma_stats_t));
+    if (stats == NULL || !gamma_stats_all(g, stats)) {
+        free(stats);
+        return;
+    }
+
+    for(uint32_t i = 0; i < g->number_of_players; i++) {
+        if(stats[i].busy_fields > best_score) {
+            best_score = stats[i].busy_fields;
         }
     }
 
     for (uint32_t i = 1; i <= g->number_of_players; i++) {
-        if(gamma_busy_fields(g, i) == best_score) {
+        uint64_t busy_fields = stats[i - 1].busy_fields;
+        if(busy_fields == best_score) {
             frame_colour();
         }
-        printf("%"PRIu32, i);
+        screen_uint64(i);
         for(int j = get_field_size(i); j < PLAYER_WIDTH; j++) {
-            printf(" ");
+            screen_write(" ", 1);
         }
-        printf(" | ");
-        for(int j = get_field_size(gamma_busy_fields(g, i)); j < BUSY_WIDTH; j++) {
-            printf(" ");
+        screen_write(" | ", 3);
+        for(int j = get_field_size(busy_fields); j < BUSY_WIDTH; j++) {
+            screen_write(" ", 1);
         }
-        printf("%"PRIu64"\n", gamma_busy_fields(g, i));
+        screen_uint64(busy_fields);
+        screen_write("\n", 1);
         reset_colour();
     }
+    free(stats);
+    screen_flush();
+}
+
+static bool golden_possible(gamma_t *g, uint32_t player, bool *golden,
+                            bool *golden_known) {
+    if (golden == NULL) {
+        return gamma_golden_possible(g, player);
+    }
+    if (!*golden_known) {
+        *golden_known = gamma_golden_possible_all(g, golden);
+    }
+    return golden[player - 1];
 }
 
 static int get_arrow(int c) {
@@ -386,13 +647,14 @@ static int get_arrow(int c) {
 }
 
 static int read_input() {
-    int c = getchar();
+    screen_flush();
+    int c = reader_getc(input());
     if (c == ESC_CHAR) {
-        c = getchar();
+        c = reader_getc(input());
         if (c != '[') {
             return c;
         }
-        c = getchar();
+        c = reader_getc(input());
         return get_arrow(c);
     }
     return c;
@@ -437,33 +699,45 @@ static int process_input(int input, gamma_t *g, uint32_t player, uint32_t *x, ui
 }
 
 void interactive_mode(gamma_t *g) {
-    atexit(reset_colour);
+    frame_t frame = {.valid = false, .stale = true};
+
     enable_raw_mode();
     hide_cursor();
 
-    if (!check_console_size(g)) {
+    if (!check_console_size(g, &frame)) {
         clear_console();
-        printf("The console window is too small!\n"
-               "Resize it and press any key to start the game.\n"
-               "Ctrl+D terminates the program.\n");
-        while (!check_console_size(g)) {
+        screen_text("The console window is too small!\n"
+                    "Resize it and press any key to start the game.\n"
+                    "Ctrl+D terminates the program.\n");
+        while (!check_console_size(g, &frame)) {
             int c = read_input();
-            if (c == END) {
+            if (c == END || c == EOF) {
                 clear_console();
                 return;
             }
         }
     }
 
+    frame.board = new_window_buffer(g, &frame);
+    frame.previous = new_window_buffer(g, &frame);
+    if (frame.board == NULL || frame.previous == NULL) {
+        free(frame.board);
+        free(frame.previous);
+        return;
+    }
+
     uint32_t player = 0;
     uint32_t unable_move = 0;
+    bool *golden = malloc(g->number_of_players * sizeof(bool));
+    bool golden_known = false;
 
     while (unable_move < g->number_of_players) {
         player++;
         if (player > g->number_of_players) {
             player = 1;
         }
-        if (gamma_free_fields(g, player) == 0 && !gamma_golden_possible(g, player)) {
+        bool can_golden = golden_possible(g, player, golden, &golden_known);
+        if (gamma_free_fields(g, player) == 0 && !can_golden) {
             unable_move++;
             continue;
         }
@@ -475,17 +749,25 @@ void interactive_mode(gamma_t *g) {
         uint32_t y = g->board_height / 2;
 
         while (!end_of_move) {
-            print_game(g, x, y, player);
+            print_game(g, &frame, x, y, player, can_golden);
             int read = read_input();
             int result = process_input(read, g, player, &x, &y);
             if (result == -1) {
-                end_of_game(g);
+                end_of_game(g, &frame);
+                free(golden);
+                free(frame.board);
+                free(frame.previous);
                 return;
             }
             if (result == 1) {
                 end_of_move = true;
+                golden_known = false;
+                frame.stale = true;
             }
         }
     }
-    end_of_game(g);
+    end_of_game(g, &frame);
+    free(golden);
+    free(frame.board);
+    free(frame.previous);
 }
@@ -12,28 +12,65 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <errno.h>
+#include <string.h>
 #include "helper-f.h"
 #include "gamma.h"
 #include "ansi-escapes.h"
+#include "buffered-io.h"
 
 /** @brief Struktura przechowująca informacje o poleceniu. */
 typedef struct line {
     uint8_t number_of_args; ///< liczba argumentów polecenia
     char command;           ///< rodzaj polecenia
-    uint32_t arg[4];        ///< argumenty polecenia
+    uint32_t arg[5];        ///< argumenty polecenia
 } line_t;
 
+/** @brief Struktura przechowująca ostatnią wyświetloną klatkę trybu
+ * interaktywnego.
+ * Pozwala przy kolejnym wyświetleniu wypisać tylko zmienione pola planszy
+ * i wiersze stanu gracza. Wyświetlany jest tylko mieszczący się w konsoli
+ * prostokątny fragment planszy, który przesuwa się razem z kursorem.
+ */
+typedef struct frame {
+    char *board;            ///< wyświetlony opis fragmentu planszy
+    char *previous;         ///< opis fragmentu przed ostatnią zmianą
+    uint64_t buffer_size;   ///< rozmiar buforów z opisami fragmentu
+    uint32_t view_x;        ///< pierwsza wyświetlana kolumna planszy
+    uint32_t view_y;        ///< pierwszy wyświetlany wiersz planszy
+    uint32_t view_width;    ///< liczba wyświetlanych kolumn
+    uint32_t view_height;   ///< liczba wyświetlanych wierszy
+    bool valid;             ///< czy konsola zawiera wyświetloną klatkę
+    bool stale;             ///< czy stan planszy mógł się zmienić
+    uint32_t cursor_x;      ///< wyświetlona kolumna kursora
+    uint32_t cursor_y;      ///< wyświetlony wiersz kursora
+    uint32_t player;        ///< wyświetlony numer gracza
+    uint64_t free_fields;   ///< wyświetlona liczba wolnych pól
+    uint64_t busy_fields;   ///< wyświetlona liczba zajętych pól
+    bool golden;            ///< czy wyświetlono możliwość złotego ruchu
+} frame_t;
+
 /** @brief Tworzy określoną przez użytkownika grę i zwraca jej tryb.
  * Funkcja przyjmuje jako argument podwójny wskaźnik na grę. Jeśli użytkownik
  * poprawnie określił grę to funkcja modyfikuję argument na wskaźnik do gry o
  * określonych parametrach. Zwracany jest oczekiwany przez użytkownika tryb gry:
  * B - tryb wsadowy, I - tryb interaktywny, 0 - użytkownik nie określił żadnej gry.
+ * Opcjonalny piąty argument polecenia B lub I to numer topologii planszy
+ * (@ref gamma_topology_t): 0 - zwykła siatka, 1 - torus, 2 - siatka
+ * sześciokątów, 3 - sąsiedztwo ośmiu pól. Bez niego gra ma zwykłą siatkę.
  * @param[in] g             - podwójny wskaźnik na strukturę przechowującą stan gry,
  * @param[in] line_number   - wskaźnik na numer linijki ostatniego polecenia.
  */
 char mode_selection(gamma_t **g, unsigned long *line_number);
 
 /** @brief Przejście do trybu wsadowego.
+ * Poza poleceniami m, g, b, f, q i p obsługiwane jest bezargumentowe
+ * polecenie Q, które wypisuje w jednej linijce oddzielone spacjami wyniki
+ * @ref gamma_golden_possible dla kolejnych graczy, bezargumentowe
+ * polecenie S, które dla kolejnych graczy wypisuje po jednej linijce z liczbą
+ * zajętych pól, liczbą wolnych pól, liczbą obszarów i możliwością wykonania
+ * złotego ruchu, oraz bezargumentowe polecenie C, które wypisuje w jednej
+ * linijce liczniki operacji silnika w kolejności pól @ref gamma_counters_t
+ * i zeruje je. Pierwsze polecenie C włącza liczniki i wypisuje same zera.
  * @param[in] g             - wskaźnik na strukturę przechowującą stan gry,
  * @param[in] line_number   - wskaźnik na numer linijki ostatniego polecenia.
  */
@@ -0,0 +1,211 @@
+#include "journal.h"
+
+#define JOURNAL_INITIAL_CAPACITY 64
+
+static bool reserve_entries(journal_entry_t **entries, uint64_t *capacity,
+                            uint64_t length) {
+    if (length < *capacity) {
+        return true;
+    }
+    uint64_t new_capacity = *capacity == 0 ?
+                            JOURNAL_INITIAL_CAPACITY : 2 * *capacity;
+    if (new_capacity > SIZE_MAX / sizeof(journal_entry_t)) {
+        return false;
+    }
+    journal_entry_t *new_entries =
+            realloc(*entries, new_capacity * sizeof(journal_entry_t));
+    if (!new_entries) {
+        return false;
+    }
+    *entries = new_entries;
+    *capacity = new_capacity;
+    return true;
+}
+
+static bool reserve_players(journal_t *j) {
+    if (j->players_length < j->players_capacity) {
+        return true;
+    }
+    uint64_t new_capacity = j->players_capacity == 0 ?
+                            JOURNAL_INITIAL_CAPACITY : 2 * j->players_capacity;
+    if (new_capacity > SIZE_MAX / sizeof(player_t)) {
+        return false;
+    }
+    player_t *new_players = realloc(j->players,
+                                    new_capacity * sizeof(player_t));
+    if (!new_players) {
+        return false;
+    }
+    j->players = new_players;
+    j->players_capacity = new_capacity;
+    return true;
+}
+
+static void fail(journal_t *j) {
+    j->failed = true;
+    j->length = 0;
+    j->players_length = 0;
+    j->redo_length = 0;
+}
+
+static void push_entry(journal_t *j, journal_kind_t kind, uint64_t index,
+                       uint64_t value) {
+    if (!reserve_entries(&j->entries, &j->capacity, j->length)) {
+        fail(j);
+        return;
+    }
+    j->entries[j->length++] = (journal_entry_t) {kind, index, value};
+}
+
+bool journal_start(gamma_t *g) {
+    journal_t *j = &g->journal;
+    if (j->enabled) {
+        return true;
+    }
+    j->stamps = calloc(g->number_of_players, sizeof(uint64_t));
+    if (!j->stamps) {
+        return false;
+    }
+    j->enabled = true;
+    j->failed = false;
+    j->moves = 0;
+    return true;
+}
+
+void journal_stop(gamma_t *g) {
+    journal_t *j = &g->journal;
+    free(j->entries);
+    free(j->players);
+    free(j->stamps);
+    free(j->redo);
+    *j = (journal_t) {0};
+}
+
+void journal_begin(gamma_t *g, journal_kind_t kind, uint32_t player,
+                   uint32_t x, uint32_t y) {
+    journal_t *j = &g->journal;
+    if (!j->enabled) {
+        return;
+    }
+    j->failed = false;
+    j->moves++;
+    push_entry(j, kind, player, (uint64_t) x << 32 | y);
+    if (!j->failed) {
+        push_entry(j, JOURNAL_GAME, g->active_players, g->all_free_fields);
+    }
+}
+
+void journal_cell(gamma_t *g, journal_kind_t kind, uint64_t index,
+                  uint64_t value) {
+    journal_t *j = &g->journal;
+    if (!j->enabled || j->failed) {
+        return;
+    }
+    push_entry(j, kind, index, value);
+}
+
+void journal_player(gamma_t *g, uint32_t player) {
+    journal_t *j = &g->journal;
+    if (!j->enabled || j->failed || j->stamps[player - 1] == j->moves) {
+        return;
+    }
+    if (!reserve_players(j)) {
+        fail(j);
+        return;
+    }
+    j->stamps[player - 1] = j->moves;
+    j->players[j->players_length] = *get_player(g, player);
+    push_entry(j, JOURNAL_PLAYER, player, j->players_length);
+    j->players_length++;
+}
+
+static void restore_owner(gamma_t *g, uint64_t index, uint32_t player) {
+    uint32_t x, y;
+    get_coordinates(g, index, &x, &y);
+    uint32_t *owner = get_chunk(g, index)->owners + (index & CHUNK_MASK);
+    bitplanes_move(&g->planes, x, y, *owner, player);
+    *owner = player;
+}
+
+static bool own_last_move(gamma_t *g) {
+    journal_t *j = &g->journal;
+    for (uint64_t i = j->length; i > 0; i--) {
+        journal_entry_t e = j->entries[i - 1];
+        if (e.kind == JOURNAL_MOVE || e.kind == JOURNAL_GOLDEN_MOVE) {
+            break;
+        }
+        if (e.kind != JOURNAL_OWNER && e.kind != JOURNAL_PARENT &&
+            e.kind != JOURNAL_RANK) {
+            continue;
+        }
+        if (!chunks_own(&g->chunks, e.index)) {
+            return false;
+        }
+        if (e.kind == JOURNAL_OWNER) {
+            uint32_t x, y;
+            get_coordinates(g, e.index, &x, &y);
+            if (!bitplanes_own(&g->planes, y)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool journal_undo(gamma_t *g, journal_entry_t *move) {
+    journal_t *j = &g->journal;
+    if (!j->enabled || !own_last_move(g)) {
+        return false;
+    }
+    while (j->length > 0) {
+        journal_entry_t e = j->entries[--j->length];
+        switch (e.kind) {
+            case JOURNAL_MOVE:
+            case JOURNAL_GOLDEN_MOVE:
+                *move = e;
+                return true;
+            case JOURNAL_GAME:
+                g->active_players = (uint32_t) e.index;
+                g->all_free_fields = e.value;
+                break;
+            case JOURNAL_OWNER:
+                restore_owner(g, e.index, (uint32_t) e.value);
+                break;
+            case JOURNAL_PARENT:
+                get_chunk(g, e.index)->parents[e.index & CHUNK_MASK] =
+                        e.value;
+                break;
+            case JOURNAL_RANK:
+                get_chunk(g, e.index)->ranks[e.index & CHUNK_MASK] =
+                        (uint8_t) e.value;
+                break;
+            case JOURNAL_PLAYER:
+                *get_player(g, e.index) = j->players[e.value];
+                j->players_length = e.value;
+                break;
+        }
+    }
+    return false;
+}
+
+void journal_push_redo(gamma_t *g, journal_entry_t move) {
+    journal_t *j = &g->journal;
+    if (!reserve_entries(&j->redo, &j->redo_capacity, j->redo_length)) {
+        j->redo_length = 0;
+        return;
+    }
+    j->redo[j->redo_length++] = move;
+}
+
+bool journal_pop_redo(gamma_t *g, journal_entry_t *move) {
+    journal_t *j = &g->journal;
+    if (!j->enabled || j->redo_length == 0) {
+        return false;
+    }
+    *move = j->redo[--j->redo_length];
+    return true;
+}
+
+void journal_forget_redo(gamma_t *g) {
+    g->journal.redo_length = 0;
+}
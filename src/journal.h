@@ -0,0 +1,81 @@
+/** @file
+ * Dziennik ruchów umożliwiający cofanie i ponawianie ruchów w grze gamma
+ *
+ * @author Szymon Frąckowiak
+ * @date 17.10.2026
+ */
+
+#ifndef GAMMA_JOURNAL_H
+#define GAMMA_JOURNAL_H
+
+#include "helper-f.h"
+
+/** @brief Włącza dziennik ruchów.
+ * @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli dziennik jest włączony, a @p false,
+ * jeśli nie udało się zaalokować pamięci.
+ */
+bool journal_start(gamma_t *g);
+
+/** @brief Wyłącza dziennik ruchów i zwalnia zajmowaną przez niego pamięć.
+ * @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry.
+ */
+void journal_stop(gamma_t *g);
+
+/** @brief Zapisuje w dzienniku początek ruchu.
+ * @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] kind    - @ref JOURNAL_MOVE lub @ref JOURNAL_GOLDEN_MOVE,
+ * @param[in] player  - numer gracza wykonującego ruch,
+ * @param[in] x       - numer kolumny,
+ * @param[in] y       - numer wiersza.
+ */
+void journal_begin(gamma_t *g, journal_kind_t kind, uint32_t player,
+                   uint32_t x, uint32_t y);
+
+/** @brief Zapisuje w dzienniku poprzednią wartość elementu pola.
+ * @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] kind    - @ref JOURNAL_OWNER, @ref JOURNAL_PARENT
+ *                      lub @ref JOURNAL_RANK,
+ * @param[in] index   - indeks pola,
+ * @param[in] value   - wartość sprzed zmiany.
+ */
+void journal_cell(gamma_t *g, journal_kind_t kind, uint64_t index,
+                  uint64_t value);
+
+/** @brief Zapisuje w dzienniku liczniki gracza sprzed zmiany.
+ * Liczniki zapisywane są tylko przy pierwszej zmianie w bieżącym ruchu.
+ * @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  - numer gracza.
+ */
+void journal_player(gamma_t *g, uint32_t player);
+
+/** @brief Przywraca stan gry sprzed ostatniego ruchu zapisanego w dzienniku.
+ * @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] move   - wskaźnik na wpis początku cofniętego ruchu.
+ * @return Wartość @p true, jeśli ruch został cofnięty, a @p false,
+ * jeśli w dzienniku nie ma żadnego ruchu lub nie udało się skopiować
+ * współdzielonych fragmentów planszy.
+ */
+bool journal_undo(gamma_t *g, journal_entry_t *move);
+
+/** @brief Odkłada cofnięty ruch na stos ruchów do ponowienia.
+ * Jeśli nie uda się zaalokować pamięci, to stos jest czyszczony.
+ * @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] move    - wpis początku cofniętego ruchu.
+ */
+void journal_push_redo(gamma_t *g, journal_entry_t move);
+
+/** @brief Zdejmuje ruch ze stosu ruchów do ponowienia.
+ * @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] move   - wskaźnik na wpis początku zdjętego ruchu.
+ * @return Wartość @p true, jeśli stos nie był pusty, a @p false
+ * w przeciwnym przypadku.
+ */
+bool journal_pop_redo(gamma_t *g, journal_entry_t *move);
+
+/** @brief Czyści stos ruchów do ponowienia.
+ * @param[in,out] g   - wskaźnik na strukturę przechowującą stan gry.
+ */
+void journal_forget_redo(gamma_t *g);
+
+#endif //GAMMA_JOURNAL_H
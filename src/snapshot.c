@@ -0,0 +1,290 @@
+#define _GNU_SOURCE
+
+#include "gamma.h"
+#include "snapshot.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SNAPSHOT_SUFFIX ".XXXXXX"
+
+static uint64_t align_up(uint64_t n) {
+    return (n + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT *
+           SNAPSHOT_ALIGNMENT;
+}
+
+static void fill_layout(snapshot_header_t *h) {
+    uint64_t size = (uint64_t) h->board_width * h->board_height;
+    h->players_offset = sizeof(snapshot_header_t);
+    h->owners_offset = align_up(h->players_offset + (uint64_t)
+            h->number_of_players * sizeof(snapshot_player_t));
+    h->parents_offset = align_up(h->owners_offset + size * sizeof(uint32_t));
+    h->ranks_offset = h->parents_offset + size * sizeof(uint64_t);
+    h->file_size = h->ranks_offset + size * sizeof(uint8_t);
+}
+
+static bool write_data(FILE *file, const void *data, uint64_t size) {
+    return fwrite(data, 1, size, file) == size;
+}
+
+bool gamma_save(gamma_t *g, const char *path) {
+    if (g == NULL || path == NULL) {
+        return false;
+    }
+
+    snapshot_header_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_SIZE);
+    h.version = SNAPSHOT_VERSION;
+    h.byte_order = SNAPSHOT_BYTE_ORDER;
+    h.board_width = g->board_width;
+    h.board_height = g->board_height;
+    h.number_of_players = g->number_of_players;
+    h.active_players = g->active_players;
+    h.max_areas = g->max_areas;
+    h.topology = g->topology;
+    h.all_free_fields = g->all_free_fields;
+    fill_layout(&h);
+
+    size_t path_length = strlen(path);
+    char *temporary = malloc(path_length + sizeof(SNAPSHOT_SUFFIX));
+    if (temporary == NULL) {
+        return false;
+    }
+    memcpy(temporary, path, path_length);
+    memcpy(temporary + path_length, SNAPSHOT_SUFFIX, sizeof(SNAPSHOT_SUFFIX));
+    int fd = mkstemp(temporary);
+    FILE *file = fd < 0 ? NULL : fdopen(fd, "wb");
+    if (file == NULL) {
+        if (fd >= 0) {
+            close(fd);
+            unlink(temporary);
+        }
+        free(temporary);
+        return false;
+    }
+
+    bool ok = write_data(file, &h, sizeof(h));
+    for (uint32_t i = 1; ok && i <= g->number_of_players; i++) {
+        player_t *p = get_player(g, i);
+        snapshot_player_t record;
+        memset(&record, 0, sizeof(record));
+        record.busy_fields = p->busy_fields;
+        record.busy_areas = p->busy_areas;
+        record.always_free_fields = p->always_free_fields;
+        record.border_fields = p->border_fields;
+        record.safe_border_fields = p->safe_border_fields;
+        record.golden_move_used = p->golden_move_used;
+        ok = write_data(file, &record, sizeof(record));
+    }
+
+    static const char padding[SNAPSHOT_ALIGNMENT];
+    chunks_t *c = &g->chunks;
+    ok = ok && write_data(file, padding, h.owners_offset - h.players_offset -
+            (uint64_t) h.number_of_players * sizeof(snapshot_player_t));
+    for (uint32_t i = 0; ok && i < c->count; i++) {
+        chunk_slot_t *slot = get_chunk(g, (uint64_t) i << CHUNK_BITS);
+        ok = write_data(file, slot->owners,
+                        chunks_fields(c, i) * sizeof(uint32_t));
+    }
+    ok = ok && write_data(file, padding, h.parents_offset - h.owners_offset -
+            (uint64_t) g->board_width * g->board_height * sizeof(uint32_t));
+    for (uint32_t i = 0; ok && i < c->count; i++) {
+        chunk_slot_t *slot = get_chunk(g, (uint64_t) i << CHUNK_BITS);
+        ok = write_data(file, slot->parents,
+                        chunks_fields(c, i) * sizeof(uint64_t));
+    }
+    for (uint32_t i = 0; ok && i < c->count; i++) {
+        chunk_slot_t *slot = get_chunk(g, (uint64_t) i << CHUNK_BITS);
+        ok = write_data(file, slot->ranks,
+                        chunks_fields(c, i) * sizeof(uint8_t));
+    }
+
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok || rename(temporary, path) != 0) {
+        unlink(temporary);
+        ok = false;
+    }
+    free(temporary);
+    return ok;
+}
+
+static bool check_header(snapshot_header_t *h, uint64_t file_size) {
+    if (memcmp(h->magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_SIZE) != 0 ||
+        h->version != SNAPSHOT_VERSION ||
+        h->byte_order != SNAPSHOT_BYTE_ORDER) {
+        return false;
+    }
+    if (h->board_width < 1 || h->board_height < 1 ||
+        h->number_of_players < 1 || h->max_areas < 1 ||
+        h->topology >= GAMMA_TOPOLOGIES ||
+        (uint64_t) h->board_width * h->board_height > MAX_FIELDS ||
+        h->active_players > h->number_of_players ||
+        h->all_free_fields > (uint64_t) h->board_width * h->board_height) {
+        return false;
+    }
+
+    snapshot_header_t layout = *h;
+    fill_layout(&layout);
+    return h->players_offset == layout.players_offset &&
+           h->owners_offset == layout.owners_offset &&
+           h->parents_offset == layout.parents_offset &&
+           h->ranks_offset == layout.ranks_offset &&
+           h->file_size == layout.file_size &&
+           h->file_size == file_size && file_size <= SIZE_MAX;
+}
+
+static bool check_fields(gamma_t *g) {
+    uint64_t *counts = calloc(2 * (uint64_t) g->number_of_players,
+                              sizeof(uint64_t));
+    if (!counts) {
+        return false;
+    }
+    uint64_t *fields = counts;
+    uint64_t *areas = counts + g->number_of_players;
+    uint64_t size = (uint64_t) g->board_width * g->board_height;
+
+    bool ok = true;
+    for (uint32_t y = 0; ok && y < g->board_height; y++) {
+        for (uint32_t x = 0; ok && x < g->board_width; x++) {
+            uint64_t i = get_index(g, x, y);
+            chunk_slot_t *c = get_chunk(g, i);
+            uint32_t owner = c->owners[i & CHUNK_MASK];
+            if (owner == 0) {
+                continue;
+            }
+            uint64_t parent = c->parents[i & CHUNK_MASK];
+            if (owner > g->number_of_players || parent >= size ||
+                !bitplanes_own(&g->planes, y)) {
+                ok = false;
+                break;
+            }
+            chunk_slot_t *p = get_chunk(g, parent);
+            if (p->owners[parent & CHUNK_MASK] != owner ||
+                (parent != i && p->ranks[parent & CHUNK_MASK] <=
+                                c->ranks[i & CHUNK_MASK])) {
+                ok = false;
+                break;
+            }
+            fields[owner - 1]++;
+            if (parent == i) {
+                areas[owner - 1]++;
+            }
+            bitplanes_move(&g->planes, x, y, 0, owner);
+        }
+    }
+
+    uint64_t busy_fields = 0;
+    uint32_t active_players = 0;
+    for (uint32_t i = 1; ok && i <= g->number_of_players; i++) {
+        player_t *p = get_player(g, i);
+        if (p->busy_fields != fields[i - 1] ||
+            p->busy_areas != areas[i - 1] || p->busy_areas > g->max_areas) {
+            ok = false;
+        }
+        busy_fields += p->busy_fields;
+        if (p->busy_fields > 0) {
+            active_players++;
+        }
+    }
+    free(counts);
+    ok = ok && busy_fields + g->all_free_fields == size &&
+         active_players == g->active_players;
+
+    // Liczniki zależne od sąsiedztwa pól nie są wczytywane z pliku, lecz
+    // odtwarzane, gdy numery graczy na wszystkich polach są już sprawdzone.
+    for (uint32_t y = 0; ok && y < g->board_height; y++) {
+        for (uint32_t x = 0; x < g->board_width; x++) {
+            add_field_counters(g, x, y);
+        }
+    }
+    return ok;
+}
+
+static gamma_t *new_mapped_game(snapshot_header_t *h, void *map) {
+    gamma_t *g = (gamma_t *) calloc(1, sizeof(gamma_t));
+    if (!g) {
+        munmap(map, h->file_size);
+        return NULL;
+    }
+    if (!chunks_map(&g->chunks, (uint64_t) h->board_width * h->board_height,
+                    map, h->file_size, h->owners_offset, h->parents_offset,
+                    h->ranks_offset)) {
+        free(g);
+        return NULL;
+    }
+    g->players = (player_t *) calloc(h->number_of_players, sizeof(player_t));
+    if (!g->players ||
+        (h->topology == GAMMA_SQUARE &&
+         !bitplanes_init(&g->planes, h->board_width, h->board_height,
+                         h->number_of_players))) {
+        chunks_free(&g->chunks);
+        free(g->players);
+        free(g);
+        return NULL;
+    }
+
+    char *data = (char *) map;
+    g->board_width = h->board_width;
+    g->board_height = h->board_height;
+    g->number_of_players = h->number_of_players;
+    g->active_players = h->active_players;
+    g->max_areas = h->max_areas;
+    g->all_free_fields = h->all_free_fields;
+    g->topology = (uint8_t) h->topology;
+    set_neighbours(g);
+
+    for (uint32_t i = 0; i < h->number_of_players; i++) {
+        snapshot_player_t record;
+        memcpy(&record, data + h->players_offset + i * sizeof(record),
+               sizeof(record));
+        player_t *p = g->players + i;
+        p->id = 1 + i;
+        p->busy_fields = record.busy_fields;
+        p->busy_areas = record.busy_areas;
+        p->golden_move_used = record.golden_move_used != 0;
+    }
+    return g;
+}
+
+gamma_t *gamma_load(const char *path) {
+    if (path == NULL) {
+        return NULL;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat info;
+    snapshot_header_t h;
+    if (fstat(fd, &info) != 0 ||
+        pread(fd, &h, sizeof(h), 0) != (ssize_t) sizeof(h) ||
+        !check_header(&h, (uint64_t) info.st_size)) {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, h.file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                     fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    gamma_t *g = new_mapped_game(&h, map);
+    if (!g) {
+        return NULL;
+    }
+    if (!check_fields(g)) {
+        gamma_delete(g);
+        return NULL;
+    }
+    return g;
+}
@@ -0,0 +1,72 @@
+/** @file
+ * Format binarnego zapisu stanu gry gamma
+ *
+ * Plik zaczyna się nagłówkiem @ref snapshot_header_t, po którym następują
+ * rekordy @ref snapshot_player_t kolejnych graczy. Od przesunięcia
+ * wyrównanego do @ref SNAPSHOT_ALIGNMENT bajtów zapisane są kolejno tablice
+ * numerów graczy, rodziców (również od wyrównanego przesunięcia) i rang pól,
+ * w takiej samej postaci, w jakiej przechowuje je struktura gry. Dzięki temu
+ * przy wczytywaniu tablice można odwzorować w pamięci zamiast je
+ * przetwarzać. Liczby zapisane są w kolejności bajtów komputera, który
+ * utworzył plik, a pole @p byte_order pozwala odrzucić plik z komputera
+ * o innej kolejności.
+ *
+ * @author Szymon Frąckowiak
+ * @date 17.10.2026
+ */
+
+#ifndef GAMMA_SNAPSHOT_H
+#define GAMMA_SNAPSHOT_H
+
+#include <stdint.h>
+
+/** @brief Napis rozpoczynający plik z zapisem gry. */
+#define SNAPSHOT_MAGIC "GAMMASNP"
+
+/** @brief Długość napisu rozpoczynającego plik. */
+#define SNAPSHOT_MAGIC_SIZE 8
+
+/** @brief Wersja formatu zapisu. */
+#define SNAPSHOT_VERSION 3
+
+/** @brief Wartość pola @p byte_order zapisana w kolejności bajtów komputera. */
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+
+/** @brief Wyrównanie początku tablic pól w pliku. */
+#define SNAPSHOT_ALIGNMENT 4096
+
+/** @brief Nagłówek pliku z zapisem gry. */
+typedef struct snapshot_header {
+    char magic[SNAPSHOT_MAGIC_SIZE];///< napis @ref SNAPSHOT_MAGIC
+    uint32_t version;           ///< wersja formatu
+    uint32_t byte_order;        ///< wartość @ref SNAPSHOT_BYTE_ORDER
+    uint32_t board_width;       ///< szerokość planszy
+    uint32_t board_height;      ///< wysokość planszy
+    uint32_t number_of_players; ///< liczba graczy
+    uint32_t active_players;    ///< liczba różnych pionków na planszy
+    uint32_t max_areas;         ///< maksymalna liczba obszarów
+    uint32_t topology;          ///< topologia planszy (@ref gamma_topology_t)
+    uint64_t all_free_fields;   ///< całkowita liczba niezajętych pól
+    uint64_t players_offset;    ///< przesunięcie rekordów graczy
+    uint64_t owners_offset;     ///< przesunięcie tablicy numerów graczy
+    uint64_t parents_offset;    ///< przesunięcie tablicy rodziców
+    uint64_t ranks_offset;      ///< przesunięcie tablicy rang
+    uint64_t file_size;         ///< rozmiar całego pliku
+} snapshot_header_t;
+
+/** @brief Rekord liczników gracza w pliku z zapisem gry.
+ * Liczba zajętych pól i obszarów jest przy wczytywaniu porównywana
+ * z planszą, a liczniki zależne od sąsiedztwa pól są odtwarzane z planszy,
+ * więc ich zapisane wartości służą tylko do podglądu pliku.
+ */
+typedef struct snapshot_player {
+    uint64_t busy_fields;       ///< liczba zajętych pól
+    uint64_t busy_areas;        ///< liczba zajętych obszarów
+    uint64_t always_free_fields;///< liczba "zawsze" możliwych do zajęcia pól
+    uint64_t border_fields;     ///< liczba pól innych graczy sąsiadujących z graczem
+    uint64_t safe_border_fields;///< liczba takich pól niedzielących obszaru
+    uint8_t golden_move_used;   ///< czy gracz użył już złotego ruchu
+    uint8_t reserved[7];        ///< wyrównanie, zawsze zero
+} snapshot_player_t;
+
+#endif //GAMMA_SNAPSHOT_H